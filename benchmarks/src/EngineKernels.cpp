@@ -0,0 +1,260 @@
+#include <tinyxml2.h>
+
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Harness.hpp"
+#include "math/Orbit.hpp"
+#include "math/Path.hpp"
+#include "math/Rotate.hpp"
+#include "math/Scale.hpp"
+#include "math/Translate.hpp"
+#include "scene/Group.hpp"
+#include "scene/Model.hpp"
+
+// Scene time advanced per iteration, so results cannot be hoisted
+static constexpr double TIME_STEP = 1e-3;
+
+// Scenes are read from the repository root, like the engine assets
+static const char* SOLAR_SYSTEM_SCENE = "scenes/solar_system_phase_4.xml";
+
+static std::vector<glm::vec3> circlePoints(int count) {
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < count; i++) {
+    float angle = glm::two_pi<float>() * i / count;
+    points.push_back(glm::vec3(std::cos(angle), 0.0f, -std::sin(angle)) *
+                     10.0f);
+  }
+  return points;
+}
+
+template <typename T>
+static void addTransformation(const std::string& name,
+                              std::shared_ptr<T> transformation) {
+  bench::add(name, [transformation](uint64_t iterations) {
+    glm::mat4 matrix(1.0f);
+    double time = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+      bench::doNotOptimize(transformation->apply(matrix, time));
+      time += TIME_STEP;
+    }
+  });
+}
+
+/**
+ * @brief Builds a chain of rotations, translations and scales, like the
+ * nested groups of a solar system.
+ *
+ * @param depth The number of transformations.
+ * @return The transformations.
+ */
+static std::vector<std::unique_ptr<Transformation>> makeChain(int depth) {
+  std::vector<std::unique_ptr<Transformation>> chain;
+  for (int i = 0; i < depth; i++) {
+    switch (i % 3) {
+      case 0:
+        chain.push_back(
+            std::make_unique<Rotate>(0.0f, 10.0f + i, 0.0f, 1.0f, 0.0f));
+        break;
+      case 1:
+        chain.push_back(std::make_unique<Translate>(5.0f, 0.0f, 0.0f));
+        break;
+      default:
+        chain.push_back(std::make_unique<Scale>(0.9f, 0.9f, 0.9f));
+        break;
+    }
+  }
+  return chain;
+}
+
+static void addTransformationBenchmarks() {
+  addTransformation("Rotate::apply/timed",
+                    std::make_shared<Rotate>(0.0f, 10.0f, 0.0f, 1.0f, 0.0f));
+  addTransformation("Rotate::apply/static",
+                    std::make_shared<Rotate>(45.0f, 0.0f, 0.0f, 1.0f, 0.0f));
+  addTransformation("Scale::apply",
+                    std::make_shared<Scale>(2.0f, 2.0f, 2.0f));
+  addTransformation("Translate::apply",
+                    std::make_shared<Translate>(1.0f, 2.0f, 3.0f));
+  addTransformation("Orbit::apply/circular",
+                    std::make_shared<Orbit>(10.0f, 0.0f, 0.0f, 10.0f, 0.0f,
+                                            false));
+  addTransformation("Orbit::apply/eccentric",
+                    std::make_shared<Orbit>(10.0f, 0.6f, 5.0f, 10.0f, 0.0f,
+                                            false));
+
+  for (int points : {4, 16, 64}) {
+    std::string suffix = "/" + std::to_string(points);
+    addTransformation("Path::apply" + suffix,
+                      std::make_shared<Path>(10.0f, false,
+                                             circlePoints(points), false));
+    addTransformation("Path::apply/align" + suffix,
+                      std::make_shared<Path>(10.0f, true, circlePoints(points),
+                                             false));
+    addTransformation("Path::apply/constant_speed" + suffix,
+                      std::make_shared<Path>(10.0f, false,
+                                             circlePoints(points), false,
+                                             true));
+  }
+
+  for (int depth : {4, 16, 64}) {
+    auto chain = std::make_shared<std::vector<std::unique_ptr<Transformation>>>(
+        makeChain(depth));
+    bench::add("applyTransformations/" + std::to_string(depth),
+               [chain](uint64_t iterations) {
+                 double time = 0.0;
+                 for (uint64_t i = 0; i < iterations; i++) {
+                   bench::doNotOptimize(applyTransformations(*chain, time));
+                   time += TIME_STEP;
+                 }
+               });
+  }
+}
+
+/**
+ * @brief Evaluates a closed Catmull-Rom curve with the basis matrix, the way
+ * Path did before it precomputed its segment polynomials.
+ *
+ * Kept as the reference the polynomial evaluator is measured against.
+ */
+static glm::vec3 matrixPathPosition(const std::vector<glm::vec3>& path_points,
+                                    float time, glm::vec3& derivative) {
+  glm::vec3 position;
+
+  int point_count = path_points.size();
+  float t = time * point_count;
+  int i = floor(t);
+  float time_in_segment = t - i;
+
+  const glm::vec3& p0 = path_points[(i + point_count - 1) % point_count];
+  const glm::vec3& p1 = path_points[i % point_count];
+  const glm::vec3& p2 = path_points[(i + 1) % point_count];
+  const glm::vec3& p3 = path_points[(i + 2) % point_count];
+
+  glm::mat4 catmull_matrix = glm::transpose(
+      glm::mat4(-0.5f, 1.5f, -1.5f, 0.5f, 1.0f, -2.5f, 2.0f, -0.5f, -0.5f, 0.0f,
+                0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f));
+
+  glm::vec4 time_vector =
+      glm::vec4(time_in_segment * time_in_segment * time_in_segment,
+                time_in_segment * time_in_segment, time_in_segment, 1.0f);
+  glm::vec4 time_derivative = glm::vec4(3 * time_in_segment * time_in_segment,
+                                        2 * time_in_segment, 1.0f, 0.0f);
+
+  for (int j = 0; j < 3; j++) {
+    glm::vec4 p = glm::vec4(p0[j], p1[j], p2[j], p3[j]);
+    glm::vec4 result = catmull_matrix * p;
+
+    position[j] = glm::dot(result, time_vector);
+    derivative[j] = glm::dot(result, time_derivative);
+  }
+
+  return position;
+}
+
+/**
+ * @brief Reads every timed path of a scene.
+ *
+ * @param filename The scene file.
+ * @return The paths, empty if the file could not be read.
+ */
+static std::vector<std::shared_ptr<Path>> loadPaths(const char* filename) {
+  std::vector<std::shared_ptr<Path>> paths;
+  tinyxml2::XMLDocument document;
+  if (document.LoadFile(filename) != tinyxml2::XML_SUCCESS ||
+      document.FirstChildElement() == nullptr) {
+    return paths;
+  }
+
+  std::vector<tinyxml2::XMLElement*> stack = {document.FirstChildElement()};
+  while (!stack.empty()) {
+    tinyxml2::XMLElement* element = stack.back();
+    stack.pop_back();
+    for (tinyxml2::XMLElement* child = element->FirstChildElement();
+         child != nullptr; child = child->NextSiblingElement()) {
+      stack.push_back(child);
+    }
+
+    if (std::string(element->Name()) != "translate" ||
+        element->Attribute("time") == nullptr) {
+      continue;
+    }
+    std::vector<glm::vec3> points;
+    for (tinyxml2::XMLElement* point = element->FirstChildElement("point");
+         point != nullptr; point = point->NextSiblingElement("point")) {
+      points.push_back(glm::vec3(point->FloatAttribute("x"),
+                                 point->FloatAttribute("y"),
+                                 point->FloatAttribute("z")));
+    }
+    if (points.size() >= 4) {
+      paths.push_back(std::make_shared<Path>(element->FloatAttribute("time"),
+                                             false, points, false));
+    }
+  }
+  return paths;
+}
+
+/**
+ * @brief Compares the matrix and polynomial path evaluators on the orbits of
+ * the solar system, one iteration evaluating every path once.
+ */
+static void addSolarSystemBenchmarks() {
+  auto paths = std::make_shared<std::vector<std::shared_ptr<Path>>>(
+      loadPaths(SOLAR_SYSTEM_SCENE));
+  if (paths->empty()) {
+    std::cerr << "Skipping the solar system paths, " << SOLAR_SYSTEM_SCENE
+              << " not found. Run from the repository root." << std::endl;
+    return;
+  }
+
+  bench::add("solarSystemPaths/matrix", [paths](uint64_t iterations) {
+    double time = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+      for (const std::shared_ptr<Path>& path : *paths) {
+        glm::vec3 derivative;
+        bench::doNotOptimize(matrixPathPosition(
+            path->path_points, time / path->duration, derivative));
+        bench::doNotOptimize(derivative);
+      }
+      time += TIME_STEP;
+    }
+  });
+
+  bench::add("solarSystemPaths/polynomial", [paths](uint64_t iterations) {
+    double time = 0.0;
+    for (uint64_t i = 0; i < iterations; i++) {
+      for (const std::shared_ptr<Path>& path : *paths) {
+        glm::vec3 derivative;
+        bench::doNotOptimize(
+            path->GetPathPosition(time / path->duration, derivative));
+        bench::doNotOptimize(derivative);
+      }
+      time += TIME_STEP;
+    }
+  });
+}
+
+static void addParseBenchmarks() {
+  static const std::string_view FACES[] = {"1", "12/34", "123/456/789",
+                                           "1234//5678"};
+  for (int component = 0; component < 3; component++) {
+    bench::add("parseIndex/" + std::to_string(component),
+               [component](uint64_t iterations) {
+                 for (uint64_t i = 0; i < iterations; i++) {
+                   bench::doNotOptimize(parseIndex(FACES[i & 3], component));
+                 }
+               });
+  }
+}
+
+int main(int argc, char* argv[]) {
+  addTransformationBenchmarks();
+  addSolarSystemBenchmarks();
+  addParseBenchmarks();
+  return bench::run("engine_benchmarks", argc, argv);
+}
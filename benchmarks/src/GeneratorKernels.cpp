@@ -0,0 +1,59 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Generator.hpp"
+#include "Harness.hpp"
+
+// Bezier patches are read from the repository root, like the engine assets
+static const char* TEAPOT_PATCH = "models/teapot.patch";
+
+template <typename Primitive>
+static void addPrimitive(const std::string& name, Primitive primitive) {
+  bench::add(name, [primitive](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+      Model model = primitive();
+      bench::doNotOptimize(model.indices.size());
+    }
+  });
+}
+
+int main(int argc, char* argv[]) {
+  for (int resolution : {8, 32, 128}) {
+    std::string suffix = "/" + std::to_string(resolution);
+    addPrimitive("generator::Plane" + suffix,
+                 [=] { return generator::Plane(2.0f, resolution); });
+    addPrimitive("generator::Box" + suffix,
+                 [=] { return generator::Box(2.0f, resolution); });
+    addPrimitive("generator::Sphere" + suffix, [=] {
+      return generator::Sphere(1.0f, resolution, resolution);
+    });
+    addPrimitive("generator::Cone" + suffix, [=] {
+      return generator::Cone(1.0f, 2.0f, resolution, resolution);
+    });
+    addPrimitive("generator::Cylinder" + suffix, [=] {
+      return generator::Cylinder(1.0f, 2.0f, resolution, resolution);
+    });
+    addPrimitive("generator::Torus" + suffix, [=] {
+      return generator::Torus(2.0f, 0.5f, resolution, resolution);
+    });
+  }
+
+  for (int subdivisions : {1, 3, 5}) {
+    addPrimitive("generator::Icosphere/" + std::to_string(subdivisions),
+                 [=] { return generator::Icosphere(1.0f, subdivisions); });
+  }
+
+  if (std::ifstream(TEAPOT_PATCH).good()) {
+    for (int tessellation : {4, 10, 20}) {
+      addPrimitive(
+          "generator::BezierSurface/" + std::to_string(tessellation),
+          [=] { return generator::BezierSurface(TEAPOT_PATCH, tessellation); });
+    }
+  } else {
+    std::cerr << "Skipping generator::BezierSurface, " << TEAPOT_PATCH
+              << " not found. Run from the repository root." << std::endl;
+  }
+
+  return bench::run("generator_benchmarks", argc, argv);
+}
@@ -0,0 +1,219 @@
+#include "Harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace bench {
+
+struct Options {
+  std::string filter;
+  std::string jsonPath;
+  int repetitions = 10;
+  double minMilliseconds = 50.0;
+  int cpu = 0;
+};
+
+static std::vector<Benchmark>& getBenchmarks() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+/**
+ * @brief Registers a benchmark, to be called before run.
+ *
+ * @param name The name of the benchmark, reported as is.
+ * @param kernel The function running the measured code.
+ */
+void add(const std::string& name, Kernel kernel) {
+  getBenchmarks().push_back({name, std::move(kernel)});
+}
+
+/**
+ * @brief Pins the calling thread to one CPU, so it is not migrated between
+ * cores with different clocks or cold caches while it is measured.
+ *
+ * @param cpu The index of the CPU, or a negative value to leave it unpinned.
+ * @return false if the thread could not be pinned.
+ */
+static bool pinToCpu(int cpu) {
+  if (cpu < 0) {
+    return true;
+  }
+#ifdef _WIN32
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+  return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+static double timeIterations(const Kernel& kernel, uint64_t iterations) {
+  auto start = std::chrono::steady_clock::now();
+  kernel(iterations);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+/**
+ * @brief Measures a benchmark.
+ *
+ * The iteration count is doubled until one run takes the minimum time, which
+ * also warms up the caches and branch predictors, and the calibrated run is
+ * then repeated.
+ *
+ * @param benchmark The benchmark.
+ * @param options The timing options.
+ * @return The time per iteration over the repetitions, in nanoseconds.
+ */
+static Result measure(const Benchmark& benchmark, const Options& options) {
+  double target = options.minMilliseconds * 1e6;
+  uint64_t iterations = 1;
+  while (timeIterations(benchmark.kernel, iterations) < target &&
+         iterations < (uint64_t(1) << 40)) {
+    iterations *= 2;
+  }
+
+  std::vector<double> samples;
+  for (int i = 0; i < options.repetitions; i++) {
+    samples.push_back(timeIterations(benchmark.kernel, iterations) /
+                      static_cast<double>(iterations));
+  }
+  std::sort(samples.begin(), samples.end());
+
+  Result result;
+  result.name = benchmark.name;
+  result.iterations = iterations;
+  result.minimum = samples.front();
+  result.median = samples[samples.size() / 2];
+  result.mean = 0.0;
+  for (double sample : samples) {
+    result.mean += sample;
+  }
+  result.mean /= samples.size();
+  result.deviation = 0.0;
+  for (double sample : samples) {
+    result.deviation += (sample - result.mean) * (sample - result.mean);
+  }
+  result.deviation = std::sqrt(result.deviation / samples.size());
+  return result;
+}
+
+static bool writeJson(const std::string& path, const char* suite,
+                      const Options& options,
+                      const std::vector<Result>& results) {
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    std::cerr << "Failed to open " << path << " for writing." << std::endl;
+    return false;
+  }
+
+  std::fprintf(file, "{\n");
+  std::fprintf(file, "  \"context\": {\n");
+  std::fprintf(file, "    \"suite\": \"%s\",\n", suite);
+  std::fprintf(file, "    \"repetitions\": %d,\n", options.repetitions);
+  std::fprintf(file, "    \"min_time_ms\": %.1f,\n", options.minMilliseconds);
+  std::fprintf(file, "    \"cpu\": %d\n", options.cpu);
+  std::fprintf(file, "  },\n");
+  std::fprintf(file, "  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result& result = results[i];
+    std::fprintf(file,
+                 "    {\"name\": \"%s\", \"iterations\": %llu, "
+                 "\"ns_min\": %.3f, \"ns_median\": %.3f, \"ns_mean\": %.3f, "
+                 "\"ns_stddev\": %.3f}%s\n",
+                 result.name.c_str(),
+                 static_cast<unsigned long long>(result.iterations),
+                 result.minimum, result.median, result.mean, result.deviation,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(file, "  ]\n");
+  std::fprintf(file, "}\n");
+  std::fclose(file);
+  return true;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    if (argument == "--filter" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (argument == "--json" && i + 1 < argc) {
+      options.jsonPath = argv[++i];
+    } else if (argument == "--repetitions" && i + 1 < argc) {
+      options.repetitions = std::max(std::atoi(argv[++i]), 1);
+    } else if (argument == "--min-time" && i + 1 < argc) {
+      options.minMilliseconds = std::atof(argv[++i]);
+    } else if (argument == "--cpu" && i + 1 < argc) {
+      options.cpu = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--filter TEXT] [--json FILE] [--repetitions N]"
+                   " [--min-time MS] [--cpu N|-1]"
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Runs the registered benchmarks matching the command line filter.
+ *
+ * Prints a table of the time per iteration and optionally writes the results
+ * as JSON.
+ *
+ * @param suite The name of the benchmark executable, reported in the JSON.
+ * @return The exit code of the program.
+ */
+int run(const char* suite, int argc, char* argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    return 1;
+  }
+
+  if (!pinToCpu(options.cpu)) {
+    std::cerr << "Could not pin to CPU " << options.cpu
+              << ", timings may be noisier." << std::endl;
+  }
+
+  std::vector<Result> results;
+  std::printf("%-44s %14s %12s %12s %10s\n", "Benchmark", "Iterations",
+              "Median ns", "Min ns", "Stddev");
+  for (const Benchmark& benchmark : getBenchmarks()) {
+    if (benchmark.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    Result result = measure(benchmark, options);
+    std::printf("%-44s %14llu %12.2f %12.2f %9.1f%%\n", result.name.c_str(),
+                static_cast<unsigned long long>(result.iterations),
+                result.median, result.minimum,
+                100.0 * result.deviation / result.mean);
+    std::fflush(stdout);
+    results.push_back(result);
+  }
+
+  if (!options.jsonPath.empty() &&
+      !writeJson(options.jsonPath, suite, options, results)) {
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace bench
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Runs the kernel the given number of times
+using Kernel = std::function<void(uint64_t iterations)>;
+
+struct Benchmark {
+  std::string name;
+  Kernel kernel;
+};
+
+struct Result {
+  std::string name;
+  uint64_t iterations;
+  double minimum;
+  double median;
+  double mean;
+  double deviation;
+};
+
+void add(const std::string& name, Kernel kernel);
+int run(const char* suite, int argc, char* argv[]);
+
+/**
+ * @brief Keeps the compiler from optimizing away a value.
+ *
+ * @param value The value a benchmark computed.
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile char sink;
+  sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+}
+
+}  // namespace bench
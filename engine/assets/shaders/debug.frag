@@ -0,0 +1,7 @@
+#version 330 core
+
+in vec3 lineColor;
+
+out vec4 fragmentColor;
+
+void main() { fragmentColor = vec4(lineColor, 1.0); }
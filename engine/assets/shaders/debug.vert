@@ -0,0 +1,13 @@
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+uniform mat4 modelViewProjection;
+
+out vec3 lineColor;
+
+void main() {
+  lineColor = color;
+  gl_Position = modelViewProjection * vec4(position, 1.0);
+}
@@ -0,0 +1,112 @@
+#version 330 core
+
+// Must match LightClusters
+const int GRID_X = 16;
+const int GRID_Y = 9;
+const int GRID_Z = 24;
+
+layout(std140) uniform Material {
+  vec4 ambient;
+  vec4 diffuse;
+  vec4 specular;
+  vec4 emission;
+  float shininess;
+};
+
+uniform bool lit;
+uniform bool textured;
+uniform sampler2D diffuseTexture;
+
+// Three texels per light: position, direction and color, see CoreLight
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterRanges;
+uniform usamplerBuffer lightIndices;
+uniform int globalLightCount;
+uniform vec2 viewportSize;
+uniform vec2 clusterDepth;  // near, GRID_Z / log(far / near)
+
+in vec3 viewPosition;
+in vec3 viewNormal;
+in vec2 fragmentTexCoord;
+
+out vec4 fragmentColor;
+
+// Same terms as the fixed-function pipeline with no local viewer. Lights with
+// a range fade out smoothly so they can be culled at that distance.
+vec3 shadeLight(int light, vec3 normal) {
+  vec4 position = texelFetch(lightData, light * 3);
+  vec4 direction = texelFetch(lightData, light * 3 + 1);
+  vec4 color = texelFetch(lightData, light * 3 + 2);
+
+  vec3 toLight;
+  float attenuation = 1.0;
+
+  if (position.w == 0.0) {
+    toLight = normalize(position.xyz);
+  } else {
+    vec3 offset = position.xyz - viewPosition;
+    float distance = length(offset);
+    toLight = offset / max(distance, 1e-6);
+
+    if (color.w > 0.0) {
+      float ratio = distance / color.w;
+      float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+      attenuation = window * window;
+    }
+  }
+
+  if (dot(-toLight, direction.xyz) < direction.w) {
+    return vec3(0.0);
+  }
+
+  float diffuseTerm = max(dot(normal, toLight), 0.0);
+  if (diffuseTerm <= 0.0) {
+    return vec3(0.0);
+  }
+
+  vec3 halfway = normalize(toLight + vec3(0.0, 0.0, 1.0));
+  float specularTerm =
+      shininess > 0.0 ? pow(max(dot(normal, halfway), 0.0), shininess) : 1.0;
+
+  return attenuation * color.rgb *
+         (diffuse.rgb * diffuseTerm + specular.rgb * specularTerm);
+}
+
+int clusterIndex() {
+  ivec2 tile = ivec2(gl_FragCoord.xy / viewportSize * vec2(GRID_X, GRID_Y));
+  int slice = int(log(-viewPosition.z / clusterDepth.x) * clusterDepth.y);
+
+  tile = clamp(tile, ivec2(0), ivec2(GRID_X - 1, GRID_Y - 1));
+  slice = clamp(slice, 0, GRID_Z - 1);
+  return (slice * GRID_Y + tile.y) * GRID_X + tile.x;
+}
+
+vec3 shade(vec3 normal) {
+  vec3 color = emission.rgb + ambient.rgb;
+
+  for (int i = 0; i < globalLightCount; i++) {
+    color += shadeLight(i, normal);
+  }
+
+  uvec2 range = texelFetch(clusterRanges, clusterIndex()).xy;
+  for (uint i = 0u; i < range.y; i++) {
+    int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+    color += shadeLight(globalLightCount + light, normal);
+  }
+
+  return clamp(color, 0.0, 1.0);
+}
+
+void main() {
+  vec4 color = vec4(1.0);
+
+  if (lit) {
+    color = vec4(shade(normalize(viewNormal)), 1.0);
+  }
+
+  if (textured) {
+    color *= texture(diffuseTexture, fragmentTexCoord);
+  }
+
+  fragmentColor = color;
+}
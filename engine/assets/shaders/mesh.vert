@@ -0,0 +1,30 @@
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+// Per draw, read from the transform of its indirect command or set as a
+// constant attribute
+layout(location = 3) in mat4 modelView;
+layout(location = 7) in mat3 normalMatrix;
+
+layout(std140) uniform Camera {
+  mat4 view;
+  mat4 projection;
+};
+
+out vec3 viewPosition;
+out vec3 viewNormal;
+out vec2 fragmentTexCoord;
+
+void main() {
+  vec4 eyePosition = modelView * vec4(position, 1.0);
+
+  // Meshes without normals use the fixed-function default normal
+  vec3 objectNormal = dot(normal, normal) > 0.0 ? normal : vec3(0.0, 0.0, 1.0);
+
+  viewPosition = eyePosition.xyz;
+  viewNormal = normalMatrix * objectNormal;
+  fragmentTexCoord = texCoord;
+  gl_Position = projection * eyePosition;
+}
@@ -0,0 +1,136 @@
+#include "Allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace debug {
+
+AllocationCounts AllocationTracker::frame[ALLOC_PHASE_COUNT];
+AllocationCounts AllocationTracker::total;
+
+// Counts of the frame in progress, written by any thread that allocates.
+// They are plain atomics so that counting never allocates itself.
+static std::atomic<uint64_t> pendingAllocations[ALLOC_PHASE_COUNT];
+static std::atomic<uint64_t> pendingFrees[ALLOC_PHASE_COUNT];
+static std::atomic<uint64_t> pendingBytes[ALLOC_PHASE_COUNT];
+
+static thread_local AllocationPhase currentPhase = ALLOC_OTHER;
+
+static const char* PHASE_NAMES[ALLOC_PHASE_COUNT] = {
+    "Other", "Events", "Update", "UI",     "Lights",
+    "Cull",  "Submit", "Debug",  "Present"};
+
+void AllocationTracker::recordAllocation(size_t bytes) {
+  pendingAllocations[currentPhase].fetch_add(1, std::memory_order_relaxed);
+  pendingBytes[currentPhase].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void AllocationTracker::recordFree() {
+  pendingFrees[currentPhase].fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sets the phase the calling thread's allocations are counted in.
+ *
+ * @return The phase that was set before.
+ */
+AllocationPhase AllocationTracker::setPhase(AllocationPhase phase) {
+  AllocationPhase previous = currentPhase;
+  currentPhase = phase;
+  return previous;
+}
+
+/**
+ * @brief Closes the counts of the current frame and starts the next one.
+ *
+ * Called once per frame by the main loop. Allocations made by other threads
+ * are counted in whichever frame they land in.
+ */
+void AllocationTracker::endFrame() {
+  for (int i = 0; i < ALLOC_PHASE_COUNT; i++) {
+    AllocationCounts& counts = frame[i];
+    counts.allocations =
+        pendingAllocations[i].exchange(0, std::memory_order_relaxed);
+    counts.frees = pendingFrees[i].exchange(0, std::memory_order_relaxed);
+    counts.bytes = pendingBytes[i].exchange(0, std::memory_order_relaxed);
+
+    total.allocations += counts.allocations;
+    total.frees += counts.frees;
+    total.bytes += counts.bytes;
+  }
+}
+
+/**
+ * @brief Sums the counts of every phase of the last frame.
+ */
+AllocationCounts AllocationTracker::getFrameTotal() {
+  AllocationCounts sum;
+  for (const AllocationCounts& counts : frame) {
+    sum.allocations += counts.allocations;
+    sum.frees += counts.frees;
+    sum.bytes += counts.bytes;
+  }
+  return sum;
+}
+
+const char* AllocationTracker::getPhaseName(AllocationPhase phase) {
+  return PHASE_NAMES[phase];
+}
+
+}  // namespace debug
+
+#if ENGINE_TRACK_ALLOCATIONS
+
+// Replacements of the global allocation functions. Every other form of new
+// and delete, but the over-aligned ones, forwards to these by default.
+
+void* operator new(std::size_t size) {
+  void* pointer = std::malloc(size > 0 ? size : 1);
+  if (!pointer) {
+    throw std::bad_alloc();
+  }
+  debug::AllocationTracker::recordAllocation(size);
+  return pointer;
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  void* pointer = std::malloc(size > 0 ? size : 1);
+  if (pointer) {
+    debug::AllocationTracker::recordAllocation(size);
+  }
+  return pointer;
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+  return ::operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept {
+  if (pointer) {
+    debug::AllocationTracker::recordFree();
+    std::free(pointer);
+  }
+}
+
+void operator delete[](void* pointer) noexcept { ::operator delete(pointer); }
+
+void operator delete(void* pointer, std::size_t) noexcept {
+  ::operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+  ::operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+  ::operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+  ::operator delete(pointer);
+}
+
+#endif
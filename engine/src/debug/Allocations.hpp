@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Global operator new and delete are only replaced, and allocations counted,
+// when ENGINE_TRACK_ALLOCATIONS is set, which debug builds do by default
+#ifndef ENGINE_TRACK_ALLOCATIONS
+#ifdef NDEBUG
+#define ENGINE_TRACK_ALLOCATIONS 0
+#else
+#define ENGINE_TRACK_ALLOCATIONS 1
+#endif
+#endif
+
+namespace debug {
+
+enum AllocationPhase {
+  ALLOC_OTHER,
+  ALLOC_EVENTS,
+  ALLOC_UPDATE,
+  ALLOC_UI,
+  ALLOC_LIGHTS,
+  ALLOC_CULL,
+  ALLOC_SUBMIT,
+  ALLOC_DEBUG,
+  ALLOC_PRESENT,
+  ALLOC_PHASE_COUNT
+};
+
+struct AllocationCounts {
+  uint64_t allocations = 0;
+  uint64_t frees = 0;
+  uint64_t bytes = 0;
+};
+
+class AllocationTracker {
+  static AllocationCounts frame[ALLOC_PHASE_COUNT];
+  static AllocationCounts total;
+
+ public:
+  static constexpr bool isCompiledIn() {
+    return ENGINE_TRACK_ALLOCATIONS != 0;
+  }
+  static void recordAllocation(size_t bytes);
+  static void recordFree();
+  static AllocationPhase setPhase(AllocationPhase phase);
+  static void endFrame();
+
+  static const AllocationCounts& getFrame(AllocationPhase phase) {
+    return frame[phase];
+  }
+  static AllocationCounts getFrameTotal();
+  static const AllocationCounts& getTotal() { return total; }
+  static const char* getPhaseName(AllocationPhase phase);
+};
+
+// Attributes the allocations of the calling thread to a phase for the rest of
+// the enclosing scope
+class AllocationScope {
+  AllocationPhase previous;
+
+ public:
+  explicit AllocationScope(AllocationPhase phase)
+      : previous(AllocationTracker::setPhase(phase)) {}
+  ~AllocationScope() { AllocationTracker::setPhase(previous); }
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+}  // namespace debug
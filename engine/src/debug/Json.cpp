@@ -0,0 +1,48 @@
+#include "Json.hpp"
+
+#include <cstdio>
+
+namespace debug {
+
+/**
+ * @brief Escapes a string for use inside a JSON string literal.
+ *
+ * Quotes and backslashes are escaped, and so are control characters, which
+ * JSON does not allow unescaped. Scene and model names come from files, so
+ * they may contain any of them.
+ */
+std::string escapeJson(const std::string& text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char code[7];
+          std::snprintf(code, sizeof(code), "\\u%04x", c);
+          escaped += code;
+        } else {
+          escaped += c;
+        }
+        break;
+    }
+  }
+  return escaped;
+}
+
+}  // namespace debug
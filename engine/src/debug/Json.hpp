@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+namespace debug {
+std::string escapeJson(const std::string& text);
+}  // namespace debug
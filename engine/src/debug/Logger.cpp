@@ -1,40 +1,339 @@
 #include "Logger.hpp"
 
-#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <thread>
 
 using namespace debug;
 
+// Longer messages are truncated
+static constexpr size_t MESSAGE_SIZE = 1024;
+// Must be a power of two
+static constexpr uint64_t RING_CAPACITY = 256;
+// Repeats of the same message text allowed in each rate window
+static constexpr uint32_t RATE_LIMIT = 20;
+static constexpr uint64_t RATE_WINDOW_NANOSECONDS = 1000000000;
+// Must match the shift of the slot hash in allowMessage
+static constexpr size_t RATE_SLOTS = 64;
+// Slots tried for a key before it is let through without a limit
+static constexpr size_t RATE_PROBES = 2;
+
+struct LogEntry {
+  std::atomic<uint64_t> sequence;
+  LogLevel level;
+  char message[MESSAGE_SIZE];
+};
+
+struct RateSlot {
+  std::atomic<uint64_t> key{0};
+  std::atomic<uint64_t> windowStart{0};
+  std::atomic<uint32_t> count{0};
+  std::atomic<uint32_t> suppressed{0};
+};
+
 /**
- * @brief Logs a message with a specified log level.
- *
- * This function outputs a message to the standard output or error stream
- * based on the provided log level. The message is prefixed with a label
- * indicating the log level.
+ * @brief Bounded multi-producer ring drained by a background thread.
  *
- * @param message The message to be logged.
+ * Producers claim a slot with a compare-and-swap and publish it through its
+ * sequence number, so logging never takes a lock. When the ring is full the
+ * message is dropped and counted instead of waiting for the writer.
  */
-void Logger::log(LogLevel level, const std::string& message) {
+class AsyncSink {
+  LogEntry entries[RING_CAPACITY];
+  std::atomic<uint64_t> writePosition{0};
+  std::atomic<uint64_t> readPosition{0};
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<bool> running{false};
+  std::thread thread;
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+
+  void drain();
+  void run();
+
+ public:
+  AsyncSink();
+  ~AsyncSink();
+  LogEntry* claim();
+  void publish(LogEntry* entry);
+  bool isRunning() const { return running.load(std::memory_order_acquire); }
+  void flush();
+};
+
+static RateSlot rateSlots[RATE_SLOTS];
+
+static void print(LogLevel level, const char* message) {
+  FILE* stream = level == LogLevel::error ? stderr : stdout;
   switch (level) {
     case LogLevel::print:
-      std::cout << message << std::endl;
+      std::fprintf(stream, "%s\n", message);
       break;
     case LogLevel::debug:
-      std::cout << "[DEBUG] " << message << std::endl;
+      std::fprintf(stream, "[DEBUG] %s\n", message);
       break;
     case LogLevel::info:
-      std::cout << "[INFO] " << message << std::endl;
+      std::fprintf(stream, "[INFO] %s\n", message);
       break;
     case LogLevel::warning:
-      std::cout << "[WARNING] " << message << std::endl;
+      std::fprintf(stream, "[WARNING] %s\n", message);
       break;
     case LogLevel::error:
-      std::cerr << "[ERROR] " << message << std::endl;
+      std::fprintf(stream, "[ERROR] %s\n", message);
       break;
   }
 }
 
+AsyncSink::AsyncSink() {
+  for (uint64_t i = 0; i < RING_CAPACITY; i++) {
+    entries[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  running.store(true, std::memory_order_release);
+  thread = std::thread(&AsyncSink::run, this);
+}
+
+AsyncSink::~AsyncSink() {
+  running.store(false, std::memory_order_release);
+  wake.notify_one();
+  thread.join();
+  drain();
+}
+
+/**
+ * @brief Reserves the next free entry of the ring.
+ *
+ * @return The entry to fill and publish, or nullptr if the ring is full.
+ */
+LogEntry* AsyncSink::claim() {
+  uint64_t position = writePosition.load(std::memory_order_relaxed);
+  while (true) {
+    LogEntry& entry = entries[position & (RING_CAPACITY - 1)];
+    uint64_t sequence = entry.sequence.load(std::memory_order_acquire);
+    int64_t difference =
+        static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+    if (difference == 0) {
+      if (writePosition.compare_exchange_weak(position, position + 1,
+                                              std::memory_order_relaxed)) {
+        return &entry;
+      }
+    } else if (difference < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else {
+      position = writePosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * @brief Hands a filled entry over to the writer thread.
+ */
+void AsyncSink::publish(LogEntry* entry) {
+  uint64_t position = entry->sequence.load(std::memory_order_relaxed);
+  entry->sequence.store(position + 1, std::memory_order_release);
+  wake.notify_one();
+}
+
+/**
+ * @brief Writes every published entry, in order, and flushes the streams.
+ *
+ * Only the writer thread drains, except once it has been joined.
+ */
+void AsyncSink::drain() {
+  uint64_t position = readPosition.load(std::memory_order_relaxed);
+  bool wrote = false;
+  while (true) {
+    LogEntry& entry = entries[position & (RING_CAPACITY - 1)];
+    if (entry.sequence.load(std::memory_order_acquire) != position + 1) {
+      break;
+    }
+    print(entry.level, entry.message);
+    entry.sequence.store(position + RING_CAPACITY, std::memory_order_release);
+    position++;
+    wrote = true;
+  }
+  readPosition.store(position, std::memory_order_release);
+
+  uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+  if (lost > 0) {
+    char message[64];
+    std::snprintf(message, sizeof(message),
+                  "%llu log messages dropped, the ring was full.",
+                  static_cast<unsigned long long>(lost));
+    print(LogLevel::warning, message);
+    wrote = true;
+  }
+
+  if (wrote) {
+    std::fflush(stdout);
+    std::fflush(stderr);
+  }
+}
+
+void AsyncSink::run() {
+  while (running.load(std::memory_order_acquire)) {
+    drain();
+    // Producers never take the mutex, so a missed wake-up only delays the
+    // next drain by the timeout
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wake.wait_for(lock, std::chrono::milliseconds(10));
+  }
+}
+
+/**
+ * @brief Waits until every message logged so far has been written.
+ */
+void AsyncSink::flush() {
+  uint64_t target = writePosition.load(std::memory_order_acquire);
+  while (running.load(std::memory_order_acquire) &&
+         readPosition.load(std::memory_order_acquire) < target) {
+    wake.notify_one();
+    std::this_thread::yield();
+  }
+}
+
+static AsyncSink& getSink() {
+  static AsyncSink sink;
+  return sink;
+}
+
+/**
+ * @brief Applies the rate limit of a message text.
+ *
+ * A key is limited in the slot it hashes to or in the next one. A slot is
+ * only taken over when it is free or the window of its key has expired, so
+ * a colliding key cannot keep resetting the window of another. A key finding
+ * both slots busy is let through without a limit.
+ *
+ * @param key A hash of the message text.
+ * @param suppressed Set to the messages the slot suppressed in its previous
+ * window, to be reported before this one.
+ * @return false if the message should be suppressed.
+ */
+static bool allowMessage(uint64_t key, uint32_t& suppressed) {
+  size_t hash = (key * 0x9E3779B97F4A7C15ull) >> 58;
+  uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+
+  suppressed = 0;
+  for (size_t probe = 0; probe < RATE_PROBES; probe++) {
+    RateSlot& slot = rateSlots[(hash + probe) & (RATE_SLOTS - 1)];
+    uint64_t owner = slot.key.load(std::memory_order_relaxed);
+    bool expired = now - slot.windowStart.load(std::memory_order_relaxed) >=
+                   RATE_WINDOW_NANOSECONDS;
+
+    if (owner != key) {
+      if ((owner != 0 && !expired) ||
+          !slot.key.compare_exchange_strong(owner, key,
+                                            std::memory_order_relaxed)) {
+        continue;
+      }
+      expired = true;
+    }
+
+    if (expired) {
+      slot.windowStart.store(now, std::memory_order_relaxed);
+      slot.count.store(0, std::memory_order_relaxed);
+      suppressed = slot.suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    if (slot.count.fetch_add(1, std::memory_order_relaxed) >= RATE_LIMIT) {
+      slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+  return true;
+}
+
+/**
+ * @brief Copies a message into the log ring.
+ *
+ * Messages are rate limited by their text, so repeats of one message are
+ * suppressed while different messages from the same call site all get
+ * through. Messages logged once the writer thread has stopped, during static
+ * destruction, are printed synchronously instead.
+ */
+static void enqueue(LogLevel level, const char* message) {
+  uint32_t suppressed;
+  if (!allowMessage(std::hash<std::string_view>()(message), suppressed)) {
+    return;
+  }
+
+  AsyncSink& sink = getSink();
+  if (!sink.isRunning()) {
+    print(level, message);
+    return;
+  }
+
+  if (suppressed > 0) {
+    LogEntry* entry = sink.claim();
+    if (entry != nullptr) {
+      entry->level = LogLevel::warning;
+      std::snprintf(entry->message, MESSAGE_SIZE,
+                    "%u repeated log messages were suppressed.",
+                    suppressed);
+      sink.publish(entry);
+    }
+  }
+
+  LogEntry* entry = sink.claim();
+  if (entry == nullptr) {
+    return;
+  }
+  entry->level = level;
+  std::snprintf(entry->message, MESSAGE_SIZE, "%s", message);
+  sink.publish(entry);
+}
+
+/**
+ * @brief Logs a message with a specified log level.
+ *
+ * The message is copied into the log ring and written to the standard output
+ * or error stream by a background thread, prefixed with a label indicating
+ * the log level.
+ *
+ * @param message The message to be logged.
+ */
+void Logger::log(LogLevel level, const std::string& message) {
+  if (!isEnabled(level)) {
+    return;
+  }
+  enqueue(level, message.c_str());
+}
+
+/**
+ * @brief Formats and logs a message with a specified log level.
+ *
+ * The message is formatted on the stack, then rate limited by its text like
+ * any other.
+ */
+void Logger::write(LogLevel level, const char* format, ...) {
+  char message[MESSAGE_SIZE];
+  va_list arguments;
+  va_start(arguments, format);
+  std::vsnprintf(message, sizeof(message), format, arguments);
+  va_end(arguments);
+  enqueue(level, message);
+}
+
 void Logger::error(const std::string& message) {
   log(LogLevel::error, message);
 }
 
-void Logger::info(const std::string& message) { log(LogLevel::info, message); }
\ No newline at end of file
+void Logger::info(const std::string& message) { log(LogLevel::info, message); }
+
+/**
+ * @brief Blocks until every message logged so far has been written.
+ *
+ * Meant for exit paths, never the render loop.
+ */
+void Logger::flush() { getSink().flush(); }
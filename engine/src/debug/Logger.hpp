@@ -2,14 +2,46 @@
 
 #include <string>
 
+// Messages below this level are compiled out: 0 print, 1 debug, 2 info,
+// 3 warning, 4 error
+#ifndef ENGINE_LOG_LEVEL
+#ifdef NDEBUG
+#define ENGINE_LOG_LEVEL 2
+#else
+#define ENGINE_LOG_LEVEL 0
+#endif
+#endif
+
 namespace debug {
 enum class LogLevel { print, debug, info, warning, error };
 
 class Logger {
   static void log(LogLevel level, const std::string& message);
+  static void write(LogLevel level, const char* format, ...);
 
  public:
+  static constexpr bool isEnabled(LogLevel level) {
+    return static_cast<int>(level) >= ENGINE_LOG_LEVEL;
+  }
+
   static void error(const std::string& message);
   static void info(const std::string& message);
+
+  // printf-style variants, formatted on the stack without building a
+  // std::string
+  template <typename... Args>
+  static void errorf(const char* format, Args... args) {
+    if (isEnabled(LogLevel::error)) {
+      write(LogLevel::error, format, args...);
+    }
+  }
+  template <typename... Args>
+  static void infof(const char* format, Args... args) {
+    if (isEnabled(LogLevel::info)) {
+      write(LogLevel::info, format, args...);
+    }
+  }
+
+  static void flush();
 };
-}  // namespace debug
\ No newline at end of file
+}  // namespace debug
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+namespace debug {
+size_t getPeakResidentBytes();
+}  // namespace debug
@@ -0,0 +1,227 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+#include "Logger.hpp"
+
+namespace debug {
+
+static Logger logger;
+
+// Events copied at a time when searching a ring backwards for a frame
+static constexpr uint64_t READ_CHUNK = 256;
+
+std::atomic<bool> Profiler::enabled{false};
+std::vector<ProfileRing*> Profiler::rings;
+uint64_t Profiler::frameStarts[2] = {0, 0};
+
+static std::mutex ringsMutex;
+
+// Reused by getLastFrame so that reading the timeline does not allocate once
+// the buffer has grown, guarded by ringsMutex
+static std::vector<ProfileEvent> readChunk;
+
+/**
+ * @brief Records a finished zone.
+ *
+ * Only the thread that owns the ring writes to it. The head is published
+ * after the event, so readers never see an event before it is written, and
+ * the oldest events are overwritten once the ring is full.
+ */
+void ProfileRing::push(const char* name, uint64_t start, uint64_t end,
+                       uint32_t depth) {
+  uint64_t index = head.load(std::memory_order_relaxed);
+  events[index % CAPACITY] = {name, start, end, depth, thread};
+  head.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Copies the events with indices in [from, to) out of the ring.
+ *
+ * Events the owner overwrote while they were copied are dropped from the
+ * front of the copy.
+ *
+ * @param from The index of the first event.
+ * @param to The index after the last event, at most the current head.
+ * @param out The vector the events are appended to.
+ */
+void ProfileRing::read(uint64_t from, uint64_t to,
+                       std::vector<ProfileEvent>& out) const {
+  size_t first = out.size();
+  for (uint64_t i = from; i < to; i++) {
+    out.push_back(events[i % CAPACITY]);
+  }
+
+  uint64_t current = head.load(std::memory_order_acquire);
+  uint64_t valid = current > CAPACITY ? current - CAPACITY : 0;
+  if (valid > from) {
+    uint64_t torn = std::min(valid, to) - from;
+    out.erase(out.begin() + first, out.begin() + first + torn);
+  }
+}
+
+uint64_t ProfileRing::getHead() const {
+  return head.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Returns the ring of the calling thread, creating it on first use.
+ */
+ProfileRing& Profiler::getRing() {
+  thread_local ProfileRing* ring = nullptr;
+  if (ring == nullptr) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    ring = new ProfileRing(static_cast<uint32_t>(rings.size()));
+    rings.push_back(ring);
+  }
+  return *ring;
+}
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds.
+ */
+uint64_t Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Marks the start of a frame of the main loop.
+ *
+ * The timeline shows the zones between the last two marks.
+ */
+void Profiler::beginFrame() {
+  frameStarts[0] = frameStarts[1];
+  frameStarts[1] = now();
+}
+
+void Profiler::setEnabled(bool enabled) {
+  Profiler::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Opens a zone on the calling thread.
+ *
+ * @return The nesting depth of the zone.
+ */
+uint32_t Profiler::enter() { return getRing().depth++; }
+
+/**
+ * @brief Closes the innermost zone of the calling thread and records it.
+ *
+ * @param name The name of the zone.
+ * @param start The timestamp the zone was opened at.
+ * @param depth The nesting depth returned by enter.
+ */
+void Profiler::leave(const char* name, uint64_t start, uint32_t depth) {
+  ProfileRing& ring = getRing();
+  ring.push(name, start, now(), depth);
+  ring.depth = depth;
+}
+
+/**
+ * @brief Collects the zones of the last complete frame from every thread.
+ *
+ * Each ring is searched backwards from its newest event, since zones are
+ * recorded in the order they end.
+ *
+ * @param events The vector the zones are written to.
+ * @param start Set to the timestamp the frame started at.
+ * @param end Set to the timestamp the frame ended at.
+ */
+void Profiler::getLastFrame(std::vector<ProfileEvent>& events, uint64_t& start,
+                            uint64_t& end) {
+  events.clear();
+  start = frameStarts[0];
+  end = frameStarts[1];
+  if (start == 0) {
+    return;
+  }
+
+  // Rings are only ever added, so holding the lock just delays the first zone
+  // of a new thread
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  std::vector<ProfileEvent>& chunk = readChunk;
+  for (const ProfileRing* ring : rings) {
+    uint64_t to = ring->getHead();
+    uint64_t oldest = to > ProfileRing::CAPACITY ? to - ProfileRing::CAPACITY
+                                                 : 0;
+    bool done = false;
+    while (!done && to > oldest) {
+      uint64_t from = std::max(oldest, to > READ_CHUNK ? to - READ_CHUNK : 0);
+      chunk.clear();
+      ring->read(from, to, chunk);
+      for (const ProfileEvent& event : chunk) {
+        if (event.end < start) {
+          done = true;
+        } else if (event.start >= start && event.end <= end) {
+          events.push_back(event);
+        }
+      }
+      to = from;
+    }
+  }
+}
+
+/**
+ * @brief Writes every recorded zone as a Chrome trace event file.
+ *
+ * The file opens in chrome://tracing or Perfetto, with one track per thread.
+ *
+ * @param path The path of the JSON file.
+ * @return true if the file was written.
+ */
+bool Profiler::exportChromeTrace(const std::string& path) {
+  std::vector<ProfileRing*> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    snapshot = rings;
+  }
+
+  std::vector<ProfileEvent> events;
+  for (const ProfileRing* ring : snapshot) {
+    uint64_t to = ring->getHead();
+    uint64_t from = to > ProfileRing::CAPACITY ? to - ProfileRing::CAPACITY
+                                               : 0;
+    ring->read(from, to, events);
+  }
+
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    logger.error("Failed to open " + path + " for writing.");
+    return false;
+  }
+
+  uint64_t origin = UINT64_MAX;
+  for (const ProfileEvent& event : events) {
+    origin = std::min(origin, event.start);
+  }
+
+  std::fprintf(file, "{\"traceEvents\":[\n");
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    std::fprintf(file,
+                 "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                 "\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                 i == 0 ? "" : ",\n", i, i == 0 ? "Main" : "Worker");
+  }
+  for (const ProfileEvent& event : events) {
+    // Thread names come first, so there is always one before an event
+    std::fprintf(file,
+                 ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                 "\"ts\":%.3f,\"dur\":%.3f}",
+                 event.name, event.thread, (event.start - origin) / 1000.0,
+                 (event.end - event.start) / 1000.0);
+  }
+  std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  std::fclose(file);
+
+  logger.info("Wrote " + std::to_string(events.size()) +
+              " profiler zones to " + path + ".");
+  return true;
+}
+
+}  // namespace debug
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Zones are compiled out of release builds unless ENGINE_PROFILING is set
+#ifndef ENGINE_PROFILING
+#ifdef NDEBUG
+#define ENGINE_PROFILING 0
+#else
+#define ENGINE_PROFILING 1
+#endif
+#endif
+
+namespace debug {
+
+struct ProfileEvent {
+  const char* name;
+  uint64_t start;
+  uint64_t end;
+  uint32_t depth;
+  uint32_t thread;
+};
+
+class ProfileRing {
+ public:
+  static constexpr uint32_t CAPACITY = 16384;
+
+ private:
+  ProfileEvent events[CAPACITY];
+  std::atomic<uint64_t> head{0};
+  uint32_t thread;
+
+ public:
+  uint32_t depth = 0;
+
+  explicit ProfileRing(uint32_t thread) : thread(thread) {}
+  void push(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+  void read(uint64_t from, uint64_t to, std::vector<ProfileEvent>& out) const;
+  uint64_t getHead() const;
+};
+
+class Profiler {
+  static std::atomic<bool> enabled;
+  static std::vector<ProfileRing*> rings;
+  static uint64_t frameStarts[2];
+
+  static ProfileRing& getRing();
+
+ public:
+  static uint64_t now();
+  static void beginFrame();
+  static void setEnabled(bool enabled);
+  static bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+  }
+  static constexpr bool isCompiledIn() { return ENGINE_PROFILING != 0; }
+  static uint32_t enter();
+  static void leave(const char* name, uint64_t start, uint32_t depth);
+  static void getLastFrame(std::vector<ProfileEvent>& events, uint64_t& start,
+                           uint64_t& end);
+  static bool exportChromeTrace(const std::string& path);
+};
+
+class ProfileZone {
+  const char* name;
+  uint64_t start = 0;
+  uint32_t depth = 0;
+  bool active;
+
+ public:
+  explicit ProfileZone(const char* name)
+      : name(name), active(Profiler::isEnabled()) {
+    if (active) {
+      depth = Profiler::enter();
+      start = Profiler::now();
+    }
+  }
+  ~ProfileZone() {
+    if (active) {
+      Profiler::leave(name, start, depth);
+    }
+  }
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+}  // namespace debug
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if ENGINE_PROFILING
+// Times the rest of the enclosing scope, the name must be a string literal
+#define PROFILE_ZONE(name) \
+  debug::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
@@ -1,82 +1,101 @@
 #include "Engine.hpp"
 
-static debug::Logger logger;
-
-/**
- * @brief Initializes the engine.
- *
- * This function sets up the display settings, initializes the window with the
- * specified settings, configures GLFW for the window, and initializes the UI
- * system.
- *
- * @return true if the engine is successfully initialized, false otherwise.
- */
-bool Engine::initialize() {
-  DisplaySettings settings;
-  settings.width = 800;
-  settings.height = 600;
-  settings.fullscreen = false;
-
-  if (!window.initialize(&settings, "[CG ENGINE] - New Scene")) {
-    return false;
-  }
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+#include "debug/Allocations.hpp"
+#include "debug/Json.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Profiler.hpp"
+#include "render/DebugDraw.hpp"
+#include "render/GeometryHeap.hpp"
 
-  configureGlfw(window);
+static debug::Logger logger;
 
-  ui.initialize(&window);
+// Simulated time per frame of a benchmark run
+static constexpr double BENCHMARK_STEP = 1.0 / 60.0;
 
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+// Frames --check-allocations lets fill the reused buffers before it checks
+static constexpr int ALLOCATION_WARMUP_FRAMES = 60;
 
-  return true;
+static const char* glslVersion(RendererBackend renderer) {
+  return renderer == CORE ? "#version 330 core" : "#version 130";
 }
 
 /**
- * @brief Initializes the engine from an XML file.
+ * @brief Creates the window and GL context for the selected renderer.
  *
- * This function loads and parses an XML file to initialize the engine's
- * settings, including window display settings, camera settings, and scene
- * graph.
+ * The core renderer needs a 3.3 core profile context, and its shaders are
+ * compiled as soon as the context is current.
  *
- * @param filename The path to the XML file to load.
- * @return true if the initialization is successful, false otherwise.
+ * @param display The display settings of the window.
+ * @param title The title of the window.
+ * @return true if the window and renderer are ready.
  */
-bool Engine::initializeFromFile(const string& filename) {
-  tinyxml2::XMLDocument doc;
+bool Engine::createWindow(DisplaySettings& display, const string& title) {
+  bool core = settings.getRenderer() == CORE;
+  display.coreProfile = core;
+  display.offscreen = settings.getOffscreen();
 
-  if (doc.LoadFile(filename.c_str()) != tinyxml2::XML_SUCCESS) {
-    logger.error("Failed to load file: " + filename);
+  if (!window.initialize(&display, title.c_str())) {
     return false;
   }
 
-  tinyxml2::XMLElement* root = doc.FirstChildElement("world");
+  configureGlfw(window);
 
-  if (root == nullptr) {
-    logger.error("Failed to find root element in file: " + filename);
+  if (core && !coreRenderer.initialize("engine/assets/shaders/mesh.vert",
+                                       "engine/assets/shaders/mesh.frag")) {
+    logger.error("Failed to initialize the core profile renderer.");
     return false;
   }
 
-  // Window
-
-  tinyxml2::XMLElement* windowElement = root->FirstChildElement("window");
-
-  if (windowElement == nullptr) {
-    logger.error("Failed to find window element in file: " + filename);
+  if (display.offscreen &&
+      !offscreenTarget.initialize(display.width, display.height)) {
+    logger.error("Failed to initialize offscreen rendering.");
     return false;
   }
 
+  return true;
+}
+
+/**
+ * @brief Initializes the engine.
+ *
+ * This function sets up the display settings, initializes the window with the
+ * specified settings, configures GLFW for the window, and initializes the UI
+ * system.
+ *
+ * @return true if the engine is successfully initialized, false otherwise.
+ */
+bool Engine::initialize() {
   DisplaySettings settings;
-  windowElement->QueryIntAttribute("width", &settings.width);
-  windowElement->QueryIntAttribute("height", &settings.height);
+  settings.width = 800;
+  settings.height = 600;
   settings.fullscreen = false;
 
-  if (!window.initialize(&settings, ("[CG ENGINE] - " + filename).c_str())) {
+  if (!createWindow(settings, "[CG ENGINE] - New Scene")) {
     return false;
   }
 
-  configureGlfw(window);
+  if (!this->settings.getOffscreen()) {
+    ui.initialize(&window, glslVersion(this->settings.getRenderer()));
+  }
 
-  // Camera
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+  return true;
+}
 
+/**
+ * @brief Reads the camera position, orientation and projection of a scene.
+ *
+ * @param root The world element of the scene file.
+ */
+void Engine::loadCamera(tinyxml2::XMLElement* root) {
   tinyxml2::XMLElement* cameraElement = root->FirstChildElement("camera");
 
   if (cameraElement != nullptr) {
@@ -128,6 +147,56 @@ bool Engine::initializeFromFile(const string& filename) {
       camera.setFar(far);
     }
   }
+}
+
+/**
+ * @brief Initializes the engine from an XML file.
+ *
+ * This function loads and parses an XML file to initialize the engine's
+ * settings, including window display settings, camera settings, and scene
+ * graph.
+ *
+ * @param filename The path to the XML file to load.
+ * @return true if the initialization is successful, false otherwise.
+ */
+bool Engine::initializeFromFile(const string& filename) {
+  auto loadStart = std::chrono::steady_clock::now();
+
+  tinyxml2::XMLDocument doc;
+
+  if (doc.LoadFile(filename.c_str()) != tinyxml2::XML_SUCCESS) {
+    logger.error("Failed to load file: " + filename);
+    return false;
+  }
+
+  tinyxml2::XMLElement* root = doc.FirstChildElement("world");
+
+  if (root == nullptr) {
+    logger.error("Failed to find root element in file: " + filename);
+    return false;
+  }
+
+  // Window
+
+  tinyxml2::XMLElement* windowElement = root->FirstChildElement("window");
+
+  if (windowElement == nullptr) {
+    logger.error("Failed to find window element in file: " + filename);
+    return false;
+  }
+
+  DisplaySettings settings;
+  windowElement->QueryIntAttribute("width", &settings.width);
+  windowElement->QueryIntAttribute("height", &settings.height);
+  settings.fullscreen = false;
+
+  if (!createWindow(settings, "[CG ENGINE] - " + filename)) {
+    return false;
+  }
+
+  // Camera
+
+  loadCamera(root);
 
   // Scene
 
@@ -180,6 +249,11 @@ bool Engine::initializeFromFile(const string& filename) {
         light.setCutoff(cutoff);
       }
 
+      if (type != LightType::DIRECTIONAL &&
+          lightElement->Attribute("range") != nullptr) {
+        light.setRange(lightElement->FloatAttribute("range"));
+      }
+
       tinyxml2::XMLElement* colorElement =
           lightElement->FirstChildElement("color");
       if (colorElement != nullptr) {
@@ -200,10 +274,16 @@ bool Engine::initializeFromFile(const string& filename) {
     }
   }
 
+  if (this->settings.getSyntheticLights() > 0) {
+    addSyntheticLights(this->settings.getSyntheticLights());
+  }
+
   // Setup lights
-  for (int i = 0; i < 8; ++i) {
-    glLightf(GL_LIGHT0 + i, GL_SPOT_CUTOFF, 180);
-    glDisable(GL_LIGHT0 + i);
+  if (this->settings.getRenderer() == LEGACY) {
+    for (int i = 0; i < 8; ++i) {
+      StateCache::lightf(GL_LIGHT0 + i, GL_SPOT_CUTOFF, 180);
+      StateCache::disable(GL_LIGHT0 + i);
+    }
   }
 
   tinyxml2::XMLElement* rootGroupElement = root->FirstChildElement("group");
@@ -213,13 +293,20 @@ bool Engine::initializeFromFile(const string& filename) {
     return false;
   }
   scene.setRoot(initializeGroupFromXML(rootGroupElement));
+  scene.setStaticBatching(this->settings.getStaticBatching());
 
-  ui.initialize(&window);
+  if (!this->settings.getOffscreen()) {
+    ui.initialize(&window, glslVersion(this->settings.getRenderer()));
+  }
 
   setupProjectionAndView();
 
   glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
+  auto loadEnd = std::chrono::steady_clock::now();
+  loadMilliseconds =
+      std::chrono::duration<double, std::milli>(loadEnd - loadStart).count();
+
   return true;
 }
 
@@ -239,7 +326,18 @@ bool Engine::loadNewFile(const std::string& filename) {
 
   Window::terminate();
 
+  // The heap is dropped as a whole, so there is nothing to compact
   scene.clear();
+  GeometryHeap::reset();
+  renderQueue.reset();
+  coreRenderer.reset();
+  lightSelector.reset();
+  DebugDraw::reset();
+  clock.reset();
+  scene.setTime(0.0);
+  offscreenTarget.reset();
+  gpuTimer.reset();
+  overdrawView.reset();
 
   if (!initializeFromFile(filename)) {
     logger.error("Failed to load new file: " + filename);
@@ -269,9 +367,309 @@ void Engine::configureGlfw(Window& window) {
   glfwSetKeyCallback(window.getGlfwWindow(), keyCallback);
   glfwSetCursorPosCallback(window.getGlfwWindow(), mouseCallback);
 
-  if (glewInit() != GLEW_OK) {
+  // Core profiles need GLEW to query entry points directly
+  glewExperimental = GL_TRUE;
+  GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  // EGL and OSMesa contexts have no GLX display, the GL entry points still load
+  if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) {
+    glewStatus = GLEW_OK;
+  }
+#endif
+  if (glewStatus != GLEW_OK) {
     logger.error("Failed to initialize GLEW.");
   }
+
+  // glewInit may leave GL_INVALID_ENUM behind on core profiles
+  while (glGetError() != GL_NO_ERROR) {
+  }
+
+  // A new context starts with default state
+  StateCache::invalidate();
+}
+
+/**
+ * @brief Counts the groups, transformations and models of a scene graph.
+ */
+static void countSceneGraph(const Group& group, uint64_t& nodes,
+                            uint64_t& transforms, uint64_t& animated,
+                            uint64_t& models) {
+  nodes++;
+  models += group.getModels().size();
+  for (const std::unique_ptr<Transformation>& transformation :
+       group.getTransformations()) {
+    transforms++;
+    if (!transformation->isStatic()) {
+      animated++;
+    }
+  }
+  for (const Group& child : group.getChildren()) {
+    countSceneGraph(child, nodes, transforms, animated, models);
+  }
+}
+
+/**
+ * @brief Runs the scene update without a window and reports its cost.
+ *
+ * The scene graph is loaded with GPU uploads disabled, so no GL context or
+ * display is needed. Every step advances the simulation clock by one fixed
+ * step and extracts the scene into the render queue, which evaluates every
+ * transformation and culls every model against the scene camera. Animation
+ * level of detail is disabled so every step does the full work. The timings
+ * are printed as a single line of JSON.
+ *
+ * @param filename The scene file.
+ * @param steps The number of fixed steps to simulate.
+ * @return true if the scene was loaded and simulated.
+ */
+bool Engine::simulate(const string& filename, int steps) {
+  tinyxml2::XMLDocument doc;
+
+  if (doc.LoadFile(filename.c_str()) != tinyxml2::XML_SUCCESS) {
+    logger.error("Failed to load file: " + filename);
+    return false;
+  }
+
+  tinyxml2::XMLElement* root = doc.FirstChildElement("world");
+  tinyxml2::XMLElement* rootGroupElement =
+      root != nullptr ? root->FirstChildElement("group") : nullptr;
+
+  if (rootGroupElement == nullptr) {
+    logger.error("Failed to find root group element in file: " + filename);
+    return false;
+  }
+
+  int width = 800;
+  int height = 600;
+  tinyxml2::XMLElement* windowElement = root->FirstChildElement("window");
+  if (windowElement != nullptr) {
+    windowElement->QueryIntAttribute("width", &width);
+    windowElement->QueryIntAttribute("height", &height);
+  }
+
+  loadCamera(root);
+
+  Model::setGPUUploadEnabled(false);
+  DebugDraw::setEnabled(false);
+
+  auto loadStart = std::chrono::steady_clock::now();
+  scene.setRoot(initializeGroupFromXML(rootGroupElement));
+  auto loadEnd = std::chrono::steady_clock::now();
+
+  uint64_t nodes = 0, transforms = 0, animated = 0, models = 0;
+  countSceneGraph(scene.getRoot(), nodes, transforms, animated, models);
+
+  glm::mat4 view = camera.getViewMatrix();
+  glm::mat4 projection = camera.getProjectionMatrix(
+      static_cast<float>(width) / static_cast<float>(height));
+
+  clock.reset();
+  uint64_t packets = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < steps; i++) {
+    clock.advance(clock.getStep(), 1.0);
+    scene.setTime(clock.getTime());
+
+    renderQueue.begin(view, projection, camera.getFar(),
+                      static_cast<float>(height), settings.getViewmode());
+    animationScheduler.beginFrame(false);
+    scene.collect(renderQueue, animationScheduler, false);
+    packets += renderQueue.getPacketCount();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double loadMilliseconds =
+      std::chrono::duration<double, std::milli>(loadEnd - loadStart).count();
+  double totalNanoseconds =
+      std::chrono::duration<double, std::nano>(end - start).count();
+  double stepCount = std::max(steps, 1);
+
+  char report[1024];
+  snprintf(report, sizeof(report),
+           "{\"scene\": \"%s\", \"steps\": %d, \"step_seconds\": %.6f, "
+           "\"nodes\": %llu, \"transforms\": %llu, "
+           "\"animated_transforms\": %llu, \"models\": %llu, "
+           "\"load_ms\": %.3f, \"total_ms\": %.3f, \"ns_per_step\": %.1f, "
+           "\"ns_per_node\": %.2f, \"ns_per_transform\": %.2f, "
+           "\"nodes_per_second\": %.0f, \"visible_models_per_step\": %.1f}",
+           debug::escapeJson(filename).c_str(), steps, clock.getStep(),
+           static_cast<unsigned long long>(nodes),
+           static_cast<unsigned long long>(transforms),
+           static_cast<unsigned long long>(animated),
+           static_cast<unsigned long long>(models), loadMilliseconds,
+           totalNanoseconds / 1e6, totalNanoseconds / stepCount,
+           totalNanoseconds / (stepCount * std::max<uint64_t>(nodes, 1)),
+           totalNanoseconds / (stepCount * std::max<uint64_t>(transforms, 1)),
+           stepCount * nodes * 1e9 / std::max(totalNanoseconds, 1.0),
+           packets / stepCount);
+  std::cout << report << std::endl;
+
+  return true;
+}
+
+/**
+ * @brief Writes the offscreen frame to the dump directory when requested.
+ *
+ * Frames are written every dump interval frames, and the last frame of a
+ * timed run always is.
+ *
+ * @param frame The number of the frame, starting at 1.
+ * @param last Whether this is the last frame of the run.
+ */
+void Engine::maybeDumpFrame(int frame, bool last) {
+  const std::string& directory = settings.getDumpDirectory();
+  int interval = settings.getDumpInterval();
+  if (directory.empty() || !(last || (interval > 0 && frame % interval == 0))) {
+    return;
+  }
+
+  char name[32];
+  snprintf(name, sizeof(name), "/frame_%05d.ppm", frame);
+  if (offscreenTarget.writePPM(directory + name)) {
+    logger.info("Wrote " + directory + name + ".");
+  }
+}
+
+/**
+ * @brief Moves the camera along the benchmark path.
+ *
+ * The camera orbits its target once around the up axis over the run, keeping
+ * the distance and height the scene file gives it, so every run renders the
+ * same views.
+ *
+ * @param frame The number of frames rendered so far.
+ * @param frameCount The number of frames of the run.
+ * @param offset The initial offset of the camera from its target.
+ */
+void Engine::followBenchmarkPath(int frame, int frameCount,
+                                 const glm::vec3& offset) {
+  float angle = glm::radians(360.0f) * static_cast<float>(frame) /
+                static_cast<float>(std::max(frameCount, 1));
+  glm::mat4 rotation =
+      glm::rotate(glm::mat4(1.0f), angle, glm::normalize(camera.getUp()));
+  camera.setPosition(camera.getLookingAt() +
+                     glm::vec3(rotation * glm::vec4(offset, 0.0f)));
+}
+
+/**
+ * @brief Returns a percentile of a list of samples.
+ *
+ * @param samples The samples, reordered in place.
+ * @param fraction The percentile, in [0, 1].
+ * @return The sample at that percentile.
+ */
+static double percentile(std::vector<double>& samples, double fraction) {
+  size_t index = static_cast<size_t>(fraction * (samples.size() - 1) + 0.5);
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+/**
+ * @brief Writes the results of a benchmark run as JSON.
+ *
+ * GPU times are left out when the context has no timer queries.
+ *
+ * @param frameMilliseconds The time of each frame, reordered in place.
+ * @param gpuMilliseconds The GPU time of each timed frame, reordered in
+ * place.
+ * @param gpuPhaseMilliseconds The GPU time of each phase over the timed
+ * frames.
+ * @param counters The sum of each frame counter over the run, in the order
+ * of forEachCounter.
+ */
+void Engine::writeBenchmarkReport(std::vector<double>& frameMilliseconds,
+                                  std::vector<double>& gpuMilliseconds,
+                                  const double* gpuPhaseMilliseconds,
+                                  const std::vector<double>& counters) {
+  const std::string& path = settings.getBenchmarkPath();
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    logger.error("Failed to open " + path + " for writing.");
+    return;
+  }
+
+  double frames = static_cast<double>(frameMilliseconds.size());
+  double total = 0.0;
+  for (double milliseconds : frameMilliseconds) {
+    total += milliseconds;
+  }
+
+  std::fprintf(file, "{\n");
+  std::fprintf(file, "  \"renderer\": \"%s\",\n",
+               settings.getRenderer() == CORE ? "core" : "legacy");
+  std::fprintf(file, "  \"frames\": %zu,\n", frameMilliseconds.size());
+  std::fprintf(file, "  \"load_ms\": %.3f,\n", loadMilliseconds);
+  std::fprintf(file, "  \"frame_ms\": {\n");
+  std::fprintf(file, "    \"mean\": %.4f,\n", total / frames);
+  std::fprintf(file, "    \"p50\": %.4f,\n",
+               percentile(frameMilliseconds, 0.50));
+  std::fprintf(file, "    \"p90\": %.4f,\n",
+               percentile(frameMilliseconds, 0.90));
+  std::fprintf(file, "    \"p99\": %.4f,\n",
+               percentile(frameMilliseconds, 0.99));
+  std::fprintf(file, "    \"max\": %.4f\n",
+               percentile(frameMilliseconds, 1.0));
+  std::fprintf(file, "  },\n");
+  if (!gpuMilliseconds.empty()) {
+    double gpuFrames = static_cast<double>(gpuMilliseconds.size());
+    double gpuTotal = 0.0;
+    for (double milliseconds : gpuMilliseconds) {
+      gpuTotal += milliseconds;
+    }
+
+    std::fprintf(file, "  \"gpu_ms\": {\n");
+    std::fprintf(file, "    \"mean\": %.4f,\n", gpuTotal / gpuFrames);
+    std::fprintf(file, "    \"p50\": %.4f,\n",
+                 percentile(gpuMilliseconds, 0.50));
+    std::fprintf(file, "    \"p99\": %.4f,\n",
+                 percentile(gpuMilliseconds, 0.99));
+    for (int i = 0; i < GPU_PHASE_COUNT; i++) {
+      // Phase names are single words, lower-cased for the keys
+      std::string name = GpuTimer::getPhaseName(static_cast<GpuPhase>(i));
+      std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+      std::fprintf(file, "    \"%s\": %.4f%s\n", name.c_str(),
+                   gpuPhaseMilliseconds[i] / gpuFrames,
+                   i + 1 < GPU_PHASE_COUNT ? "," : "");
+    }
+    std::fprintf(file, "  },\n");
+  }
+  size_t counter = 0;
+  forEachCounter(RenderStats(), [&](const char* name, double) {
+    std::fprintf(file, "  \"%s\": %.1f,\n", name,
+                 counters[counter++] / frames);
+  });
+  std::fprintf(file, "  \"peak_memory_mb\": %.2f\n",
+               debug::getPeakResidentBytes() / (1024.0 * 1024.0));
+  std::fprintf(file, "}\n");
+  std::fclose(file);
+
+  logger.info("Wrote benchmark results to " + path + ".");
+}
+
+/**
+ * @brief Logs the phases that allocated during the last frame.
+ *
+ * @param frame The number of the frame.
+ */
+static void reportFrameAllocations(int frame) {
+  debug::AllocationCounts counts = debug::AllocationTracker::getFrameTotal();
+  char phases[256] = "";
+  int length = 0;
+  for (int i = 0; i < debug::ALLOC_PHASE_COUNT; i++) {
+    debug::AllocationPhase phase = static_cast<debug::AllocationPhase>(i);
+    uint64_t allocations =
+        debug::AllocationTracker::getFrame(phase).allocations;
+    if (allocations > 0 && length < static_cast<int>(sizeof(phases))) {
+      length += std::snprintf(phases + length, sizeof(phases) - length,
+                              " %s %llu",
+                              debug::AllocationTracker::getPhaseName(phase),
+                              static_cast<unsigned long long>(allocations));
+    }
+  }
+  logger.errorf("Frame %d allocated %llu times (%llu bytes):%s.", frame,
+                static_cast<unsigned long long>(counts.allocations),
+                static_cast<unsigned long long>(counts.bytes), phases);
 }
 
 /**
@@ -284,34 +682,167 @@ void Engine::configureGlfw(Window& window) {
  *
  */
 void Engine::run() {
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
-  glEnableClientState(GL_VERTEX_ARRAY);
-  glEnable(GL_RESCALE_NORMAL);
+  StateCache::enable(GL_DEPTH_TEST);
+  StateCache::enable(GL_CULL_FACE);
+
+  if (settings.getRenderer() == LEGACY) {
+    StateCache::enableClientState(GL_VERTEX_ARRAY);
+    StateCache::enable(GL_RESCALE_NORMAL);
 
-  constexpr float amb[4] = {1.0f, 1.0f, 1.0f, 1.0f};
-  glLightModelfv(GL_LIGHT_MODEL_AMBIENT, amb);
+    constexpr float amb[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, amb);
+  }
+
+  int frameLimit = settings.getFrameLimit();
+  if (frameLimit > 0) {
+    // Timed runs must not wait for vertical sync
+    glfwSwapInterval(0);
+  }
 
+  int frames = 0;
+  double submitMilliseconds = 0.0;
   double lastTime = glfwGetTime();
+  double startTime = lastTime;
+
+  bool benchmark = !settings.getBenchmarkPath().empty();
+  std::vector<double> frameMilliseconds;
+  std::vector<double> gpuMilliseconds;
+  double gpuPhaseMilliseconds[GPU_PHASE_COUNT] = {};
+  uint64_t gpuResults = gpuTimer.getResultCount();
+  size_t counterCount = 0;
+  forEachCounter(RenderStats(), [&](const char*, double) { counterCount++; });
+  std::vector<double> counters(counterCount, 0.0);
+  glm::vec3 benchmarkOffset = camera.getPosition() - camera.getLookingAt();
+  if (benchmark) {
+    frameMilliseconds.reserve(frameLimit);
+    gpuMilliseconds.reserve(frameLimit);
+  }
+
+  bool checkAllocations = settings.getCheckAllocations();
+  int allocatingFrames = 0;
 
   while (!glfwWindowShouldClose(window.getGlfwWindow())) {
+    debug::Profiler::beginFrame();
+    PROFILE_ZONE("Frame");
+    frameTimes.frame(settings.getHitchFactor());
+
     double currentTime = glfwGetTime();
-    float deltaTime = static_cast<float>(currentTime - lastTime);
+    double deltaTime = currentTime - lastTime;
     lastTime = currentTime;
 
-    glfwPollEvents();
+    {
+      PROFILE_ZONE("Poll Events");
+      debug::AllocationScope allocations(debug::ALLOC_EVENTS);
+      glfwPollEvents();
+    }
 
-    camera.update(deltaTime);
+    if (benchmark) {
+      // Benchmarks replay the same frames however fast they are rendered
+      debug::AllocationScope allocations(debug::ALLOC_UPDATE);
+      deltaTime = BENCHMARK_STEP;
+      followBenchmarkPath(frames, frameLimit, benchmarkOffset);
+    } else {
+      PROFILE_ZONE("Camera Update");
+      debug::AllocationScope allocations(debug::ALLOC_UPDATE);
+      camera.update(static_cast<float>(deltaTime));
+    }
 
-    if (!settings.getPaused()) {
-      scene.updateTime(deltaTime);
+    {
+      PROFILE_ZONE("Scene Update");
+      debug::AllocationScope allocations(debug::ALLOC_UPDATE);
+      // Scene transforms are closed-form in time, so they are evaluated at
+      // the exact warped time rather than at the last fixed step
+      double warp = settings.getPaused() ? 0.0 : settings.getTimeWarp();
+      clock.advance(deltaTime, warp);
+      scene.setTime(clock.getWarpedTime());
     }
 
     render();
-    glfwSwapBuffers(window.getGlfwWindow());
+
+    frames++;
+    if (settings.getOffscreen()) {
+      PROFILE_ZONE("Flush");
+      debug::AllocationScope allocations(debug::ALLOC_PRESENT);
+      glFlush();
+      maybeDumpFrame(frames, frames == frameLimit);
+    } else {
+      PROFILE_ZONE("Swap");
+      debug::AllocationScope allocations(debug::ALLOC_PRESENT);
+      glfwSwapBuffers(window.getGlfwWindow());
+    }
+
+    submitMilliseconds += getRenderStats().submitMilliseconds;
+    if (benchmark) {
+      glFinish();
+      frameMilliseconds.push_back((glfwGetTime() - currentTime) * 1000.0);
+      size_t counter = 0;
+      forEachCounter(getRenderStats(), [&](const char*, double value) {
+        counters[counter++] += value;
+      });
+
+      if (gpuTimer.getResultCount() != gpuResults) {
+        gpuResults = gpuTimer.getResultCount();
+        gpuMilliseconds.push_back(gpuTimer.getTotalMilliseconds());
+        for (int i = 0; i < GPU_PHASE_COUNT; i++) {
+          gpuPhaseMilliseconds[i] +=
+              gpuTimer.getMilliseconds(static_cast<GpuPhase>(i));
+        }
+      }
+    }
+
+    debug::AllocationTracker::endFrame();
+    if (checkAllocations && frames > ALLOCATION_WARMUP_FRAMES &&
+        debug::AllocationTracker::getFrameTotal().allocations > 0) {
+      allocatingFrames++;
+      reportFrameAllocations(frames);
+    }
+
+    if (frameLimit > 0 && frames >= frameLimit) {
+      glfwSetWindowShouldClose(window.getGlfwWindow(), GLFW_TRUE);
+    }
+  }
+
+  if (checkAllocations) {
+    int checkedFrames = frames - ALLOCATION_WARMUP_FRAMES;
+    if (checkedFrames <= 0) {
+      logger.errorf("Checking allocations needs more than %d frames.",
+                    ALLOCATION_WARMUP_FRAMES);
+      allocationCheckPassed = false;
+    } else if (allocatingFrames > 0) {
+      logger.errorf("%d of %d steady-state frames allocated.",
+                    allocatingFrames, checkedFrames);
+      allocationCheckPassed = false;
+    } else {
+      logger.infof("No allocations in %d steady-state frames.",
+                   checkedFrames);
+    }
+  }
+
+  if (frameLimit > 0 && frames > 0) {
+    glFinish();
+    double elapsed = glfwGetTime() - startTime;
+    char summary[256];
+    snprintf(summary, sizeof(summary),
+             "Rendered %d frames with the %s renderer in %.2f s: %.3f ms/frame "
+             "(%.1f FPS), %.3f ms submit.",
+             frames, settings.getRenderer() == CORE ? "core" : "legacy",
+             elapsed, elapsed * 1000.0 / frames, frames / elapsed,
+             submitMilliseconds / frames);
+    logger.info(summary);
+  }
+
+  if (benchmark && !frameMilliseconds.empty()) {
+    writeBenchmarkReport(frameMilliseconds, gpuMilliseconds,
+                         gpuPhaseMilliseconds, counters);
   }
 
-  ui.terminate();
+  if (!settings.getTracePath().empty()) {
+    debug::Profiler::exportChromeTrace(settings.getTracePath());
+  }
+
+  if (!settings.getOffscreen()) {
+    ui.terminate();
+  }
   Window::terminate();
 }
 
@@ -325,13 +856,19 @@ void Engine::run() {
  *
  */
 void Engine::setupProjectionAndView() {
-  glMatrixMode(GL_PROJECTION);
-  glLoadIdentity();
+  glViewport(0, 0, window.width, window.height);
+
+  if (settings.getRenderer() == CORE) {
+    // The core renderer uploads its projection every frame, and a core
+    // profile context has no matrix stacks
+    return;
+  }
 
   float aspectRatio =
       static_cast<float>(window.width) / static_cast<float>(window.height);
 
-  glViewport(0, 0, window.width, window.height);
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
   gluPerspective(camera.getFov(), aspectRatio, camera.getNear(),
                  camera.getFar());
 
@@ -341,7 +878,7 @@ void Engine::setupProjectionAndView() {
 /**
  * @brief Renders the coordinate axes in the scene.
  *
- * This function draws the x-axis, y-axis, and z-axis using OpenGL lines.
+ * This function queues the x-axis, y-axis, and z-axis as debug lines.
  * Each axis is colored differently for easy identification:
  * - x-axis: red
  * - y-axis: green
@@ -350,55 +887,120 @@ void Engine::setupProjectionAndView() {
  * The axes extend from -1000 to 1000 units in their respective directions.
  */
 void Engine::renderSceneAxis() {
-  disableLightRendering();
-  glBegin(GL_LINES);
-
   // x-axis
-  glColor3f(1.0, 0.0, 0.0);
-  glVertex3f(-1000.0, 0.0, 0.0);
-  glVertex3f(1000.0, 0.0, 0.0);
+  DebugDraw::line(glm::vec3(-1000.0f, 0.0f, 0.0f),
+                  glm::vec3(1000.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 
   // y-axis
-  glColor3f(0.0, 1.0, 0.0);
-  glVertex3f(0.0, -1000.0, 0.0);
-  glVertex3f(0.0, 1000.0, 0.0);
+  DebugDraw::line(glm::vec3(0.0f, -1000.0f, 0.0f),
+                  glm::vec3(0.0f, 1000.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
   // z-axis
-  glColor3f(0.0, 0.0, 1.0);
-  glVertex3f(0.0, 0.0, -1000.0);
-  glVertex3f(0.0, 0.0, 1000.0);
-
-  glColor3f(1.0, 1.0, 1.0);
-
-  glEnd();
-  maybeEnableLightRendering();
+  DebugDraw::line(glm::vec3(0.0f, 0.0f, -1000.0f),
+                  glm::vec3(0.0f, 0.0f, 1000.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 }
 
 /**
  * @brief Renders the entire scene including UI, camera, and scene objects.
  */
 void Engine::render() {
-  ui.render();
+  PROFILE_ZONE("Render");
+  StateCache::beginFrame();
+
+  if (settings.getOffscreen()) {
+    offscreenTarget.bind();
+  } else {
+    PROFILE_ZONE("UI");
+    debug::AllocationScope allocations(debug::ALLOC_UI);
+    ui.render();
+  }
 
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-  glLoadIdentity();
+  gpuTimer.beginFrame();
 
-  camera.render();
+  bool core = settings.getRenderer() == CORE;
 
-  if (settings.getViewmode() == SHADED) {
-    renderLights();
+  float aspectRatio =
+      static_cast<float>(window.width) / static_cast<float>(window.height);
+  glm::mat4 view = camera.getViewMatrix();
+  glm::mat4 projection = camera.getProjectionMatrix(aspectRatio);
+
+  bool shaded = settings.getViewmode() == SHADED;
+
+  {
+    PROFILE_ZONE("Lights");
+    debug::AllocationScope allocations(debug::ALLOC_LIGHTS);
+    if (core) {
+      coreRenderer.setCamera(view, projection,
+                             glm::vec2(window.width, window.height));
+      coreRenderer.setLights(scene.getLights(), view);
+    } else {
+      camera.render();
+
+      if (shaded) {
+        lightSelector.begin(scene.getLights(), view);
+      }
+      maybeEnableLightRendering();
+    }
+  }
+  gpuTimer.endPhase(GPU_LIGHTS);
+
+  // Follows the UI toggle, a no-op unless it changed
+  scene.setStaticBatching(settings.getStaticBatching());
+
+  {
+    PROFILE_ZONE("Cull");
+    debug::AllocationScope allocations(debug::ALLOC_CULL);
+    renderQueue.begin(view, projection, camera.getFar(),
+                      static_cast<float>(window.height),
+                      settings.getViewmode());
+    animationScheduler.beginFrame(settings.getAnimationLod());
+    scene.collect(renderQueue, animationScheduler,
+                  settings.getStaticBatching());
+    renderQueue.sort();
   }
 
-  scene.render(settings.getViewmode(), settings.getShowNormals());
+  {
+    PROFILE_ZONE("Submit");
+    debug::AllocationScope allocations(debug::ALLOC_SUBMIT);
+    bool overdraw = settings.getViewmode() == OVERDRAW;
+    if (overdraw) {
+      overdrawView.begin();
+    }
+    if (core) {
+      coreRenderer.submit(renderQueue, settings.getMultiDrawIndirect());
+    } else {
+      renderQueue.submit(settings.getMultiDrawIndirect(),
+                         shaded ? &lightSelector : nullptr);
+    }
+    if (overdraw) {
+      overdrawView.end(core, window.width, window.height);
+    }
+  }
+  gpuTimer.endPhase(GPU_SCENE);
 
-  if (settings.getShowAxis()) {
-    renderSceneAxis();
+  {
+    PROFILE_ZONE("Debug Lines");
+    debug::AllocationScope allocations(debug::ALLOC_DEBUG);
+    if (settings.getShowNormals()) {
+      renderQueue.renderNormals(0.4f);
+    }
+    if (settings.getShowAxis()) {
+      renderSceneAxis();
+    }
+    DebugDraw::flush(view, projection, core);
   }
+  gpuTimer.endPhase(GPU_DEBUG);
 
-  ui.postRender();
+  if (!settings.getOffscreen()) {
+    PROFILE_ZONE("UI Draw");
+    debug::AllocationScope allocations(debug::ALLOC_UI);
+    ui.postRender();
+  }
+  gpuTimer.endFrame();
 }
 
 /**
@@ -419,13 +1021,28 @@ void windowSizeUpdatedCallback(GLFWwindow* window, int width, int height) {
   engine->setupProjectionAndView();
 }
 
+/**
+ * @brief Applies the polygon mode and lighting of the current view mode.
+ *
+ * Lighting is a fixed-function capability, the core renderer picks its
+ * shading from the view mode when drawing instead.
+ */
+void Engine::applyViewMode() {
+  ViewMode viewMode = settings.getViewmode();
+  glPolygonMode(GL_FRONT_AND_BACK, viewMode == WIREFRAME ? GL_LINE : GL_FILL);
+
+  if (settings.getRenderer() == LEGACY) {
+    StateCache::setEnabled(GL_LIGHTING, viewMode == SHADED);
+  }
+}
+
 /**
  * @brief Disables light rendering in the OpenGL context.
  *
  * This function disables the lighting feature in OpenGL, which is useful when
  * rendering in wireframe or flat shading modes where lighting is not needed.
  */
-void Engine::disableLightRendering() { glDisable(GL_LIGHTING); }
+void Engine::disableLightRendering() { StateCache::disable(GL_LIGHTING); }
 
 /**
  * @brief Enables light rendering in the OpenGL context if the current view mode
@@ -437,7 +1054,7 @@ void Engine::disableLightRendering() { glDisable(GL_LIGHTING); }
  */
 void Engine::maybeEnableLightRendering() {
   if (settings.getViewmode() == SHADED) {
-    glEnable(GL_LIGHTING);
+    StateCache::enable(GL_LIGHTING);
   }
 }
 
@@ -489,22 +1106,7 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action,
     engine->getSettings()->toggleNormals();
   } else if (key == GLFW_KEY_P && action == GLFW_PRESS) {
     engine->getSettings()->toggleViewmode();
-    switch (engine->getSettings()->getViewmode()) {
-      case WIREFRAME:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        glDisable(GL_LIGHTING);
-        break;
-      case FLAT:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDisable(GL_LIGHTING);
-        break;
-      case SHADED:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glEnable(GL_LIGHTING);
-        break;
-      default:
-        break;
-    }
+    engine->applyViewMode();
   }
 
   engine->getCamera()->processKeyboard(key, action);
@@ -527,22 +1129,40 @@ void mouseCallback(GLFWwindow* window, double xpos, double ypos) {
 }
 
 void glfwErrorCallback(const int error, const char* description) {
-  logger.error("GLFW Error: " + std::to_string(error) + ": " +
-               std::string(description));
+  logger.errorf("GLFW Error: %d: %s", error, description);
 }
 
 /**
- * @brief Renders all lights in the scene.
+ * @brief Scatters point lights around the camera target, for benchmarks.
+ *
+ * The lights are placed with a fixed seed so runs with the same count are
+ * comparable. Each light has a range, so only the core renderer's clustered
+ * lighting keeps them local.
  *
- * This function iterates through all lights in the scene and calls their
- * render method to display them in the OpenGL context.
+ * @param count The number of lights to add.
  */
-void Engine::renderLights() {
-  int lightIndex = 0;
-  disableLightRendering();
-  for (auto& light : scene.getLights()) {
-    light.render(lightIndex);
-    lightIndex++;
-  }
-  maybeEnableLightRendering();
+void Engine::addSyntheticLights(int count) {
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> intensity(0.2f, 1.0f);
+
+  glm::vec3 center = camera.getLookingAt();
+  float radius = std::max(glm::length(camera.getPosition() - center), 1.0f);
+
+  for (int i = 0; i < count; i++) {
+    glm::vec3 offset;
+    do {
+      offset = glm::vec3(unit(random), unit(random), unit(random));
+    } while (glm::dot(offset, offset) > 1.0f);
+
+    Light light;
+    light.setType(POINT);
+    light.setPosition(center + offset * radius);
+    light.setColor(
+        glm::vec3(intensity(random), intensity(random), intensity(random)));
+    light.setRange(radius * 0.2f);
+    scene.addLight(light);
+  }
+
+  logger.info("Added " + std::to_string(count) + " synthetic lights.");
 }
\ No newline at end of file
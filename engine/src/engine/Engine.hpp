@@ -7,12 +7,21 @@
 
 #include <string>
 
+#include "../render/CoreRenderer.hpp"
+#include "../render/GpuTimer.hpp"
+#include "../render/LightSelector.hpp"
+#include "../render/OffscreenTarget.hpp"
+#include "../render/OverdrawView.hpp"
+#include "../render/RenderQueue.hpp"
+#include "../render/StateCache.hpp"
 #include "../scene/Group.hpp"
 #include "../scene/Scene.hpp"
 #include "../ui/UI.hpp"
 #include "../window/Camera.hpp"
 #include "../window/Window.hpp"
+#include "FrameTimeHistory.hpp"
 #include "Settings.hpp"
+#include "SimulationClock.hpp"
 #include "debug/Logger.hpp"
 
 class Engine {
@@ -22,6 +31,20 @@ class Engine {
   Camera camera;
   UI ui;
   Settings settings;
+  RenderQueue renderQueue;
+  CoreRenderer coreRenderer;
+  LightSelector lightSelector;
+  AnimationScheduler animationScheduler;
+  SimulationClock clock;
+  OffscreenTarget offscreenTarget;
+  GpuTimer gpuTimer;
+  OverdrawView overdrawView;
+  FrameTimeHistory frameTimes;
+  double loadMilliseconds = 0.0;
+  bool allocationCheckPassed = true;
+
+  bool createWindow(DisplaySettings& display, const string& title);
+  void loadCamera(tinyxml2::XMLElement* root);
 
  public:
   bool initialize();
@@ -29,6 +52,13 @@ class Engine {
   bool Engine::loadNewFile(const string& filename);
   void configureGlfw(Window& window);
   void run();
+  bool simulate(const string& filename, int steps);
+  void maybeDumpFrame(int frame, bool last);
+  void followBenchmarkPath(int frame, int frameCount, const glm::vec3& offset);
+  void writeBenchmarkReport(std::vector<double>& frameMilliseconds,
+                            std::vector<double>& gpuMilliseconds,
+                            const double* gpuPhaseMilliseconds,
+                            const std::vector<double>& counters);
   void render();
   void setupProjectionAndView();
   Window* getWindow() { return &window; }
@@ -36,10 +66,21 @@ class Engine {
   Scene* getScene() { return &scene; }
   UI* getUI() { return &ui; }
   Settings* getSettings() { return &settings; }
+  RenderQueue* getRenderQueue() { return &renderQueue; }
+  const SimulationClock& getClock() const { return clock; }
+  const GpuTimer& getGpuTimer() const { return gpuTimer; }
+  const OverdrawView& getOverdrawView() const { return overdrawView; }
+  FrameTimeHistory& getFrameTimes() { return frameTimes; }
+  bool getAllocationCheckPassed() const { return allocationCheckPassed; }
+  const RenderStats& getRenderStats() {
+    return settings.getRenderer() == CORE ? coreRenderer.getStats()
+                                          : renderQueue.getStats();
+  }
+  void applyViewMode();
   void disableLightRendering();
   void maybeEnableLightRendering();
   void renderSceneAxis();
-  void renderLights();
+  void addSyntheticLights(int count);
 };
 
 void windowSizeUpdatedCallback(GLFWwindow* window, int width, int height);
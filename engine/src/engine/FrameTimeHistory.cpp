@@ -0,0 +1,83 @@
+#include "FrameTimeHistory.hpp"
+
+#include <algorithm>
+
+#include "debug/Logger.hpp"
+
+static debug::Logger logger;
+
+FrameTimeHistory::FrameTimeHistory() : start(std::chrono::steady_clock::now()) {
+  scratch.reserve(CAPACITY);
+}
+
+/**
+ * @brief Records the time since the previous frame.
+ *
+ * Frames are timed with their own clock, rather than the GLFW timer, so the
+ * history survives the window being recreated and the stall of a scene load
+ * shows up as the first frame after it.
+ *
+ * A frame taking more than hitchFactor times the median of the previous
+ * frames is counted and logged with the time since startup, so it can be
+ * matched with loads or input.
+ *
+ * @param hitchFactor How many times the median a hitch takes, 0 to disable.
+ */
+void FrameTimeHistory::frame(float hitchFactor) {
+  TimePoint now = std::chrono::steady_clock::now();
+  if (!started) {
+    started = true;
+    lastFrame = now;
+    return;
+  }
+
+  float milliseconds =
+      std::chrono::duration<float, std::milli>(now - lastFrame).count();
+  lastFrame = now;
+  frames++;
+
+  if (hitchFactor > 0.0f && count >= WARMUP_FRAMES &&
+      milliseconds > hitchFactor * p50) {
+    hitches++;
+
+    logger.infof("Hitch at %.3f s (frame %llu): %.2f ms, %.1fx the median.",
+                 std::chrono::duration<double>(now - start).count(),
+                 static_cast<unsigned long long>(frames), milliseconds,
+                 milliseconds / p50);
+  }
+
+  samples[head] = milliseconds;
+  head = (head + 1) % CAPACITY;
+  count = std::min(count + 1, CAPACITY);
+  updatePercentiles();
+}
+
+/**
+ * @brief Recomputes the percentiles of the samples in the history.
+ */
+void FrameTimeHistory::updatePercentiles() {
+  scratch.assign(samples, samples + count);
+
+  auto percentile = [this](float fraction) {
+    size_t index = static_cast<size_t>(fraction * (scratch.size() - 1) + 0.5f);
+    std::nth_element(scratch.begin(), scratch.begin() + index, scratch.end());
+    return scratch[index];
+  };
+
+  p50 = percentile(0.50f);
+  p95 = percentile(0.95f);
+  p99 = percentile(0.99f);
+  max = *std::max_element(scratch.begin(), scratch.end());
+}
+
+/**
+ * @brief Forgets the recorded frames and hitches.
+ */
+void FrameTimeHistory::reset() {
+  head = 0;
+  count = 0;
+  frames = 0;
+  hitches = 0;
+  started = false;
+  p50 = p95 = p99 = max = 0.0f;
+}
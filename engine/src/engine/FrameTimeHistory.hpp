@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class FrameTimeHistory {
+ public:
+  static constexpr uint32_t CAPACITY = 512;
+  // Frames needed before the median is trusted to detect hitches
+  static constexpr uint32_t WARMUP_FRAMES = 30;
+
+ private:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  float samples[CAPACITY] = {};
+  uint32_t head = 0;
+  uint32_t count = 0;
+  uint64_t frames = 0;
+  uint32_t hitches = 0;
+  TimePoint start;
+  TimePoint lastFrame;
+  bool started = false;
+  float p50 = 0.0f;
+  float p95 = 0.0f;
+  float p99 = 0.0f;
+  float max = 0.0f;
+  std::vector<float> scratch;
+
+  void updatePercentiles();
+
+ public:
+  FrameTimeHistory();
+  void frame(float hitchFactor);
+  void reset();
+
+  const float* getSamples() const { return samples; }
+  uint32_t getCount() const { return count; }
+  // Offset of the oldest sample, for plots reading the ring in order
+  uint32_t getOffset() const { return count < CAPACITY ? 0 : head; }
+  float getLast() const {
+    return count > 0 ? samples[(head + CAPACITY - 1) % CAPACITY] : 0.0f;
+  }
+  float getP50() const { return p50; }
+  float getP95() const { return p95; }
+  float getP99() const { return p99; }
+  float getMax() const { return max; }
+  uint32_t getHitches() const { return hitches; }
+};
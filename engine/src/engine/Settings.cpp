@@ -15,6 +15,9 @@ void Settings::toggleViewmode() {
       viewMode = SHADED;
       break;
     case SHADED:
+      viewMode = OVERDRAW;
+      break;
+    case OVERDRAW:
       viewMode = WIREFRAME;
       break;
   }
@@ -26,4 +29,34 @@ ViewMode Settings::getViewmode() { return viewMode; }
 
 bool Settings::getShowAxis() { return showAxis; }
 
-bool Settings::getPaused() { return isPaused; }
\ No newline at end of file
+bool Settings::getPaused() { return isPaused; }
+
+bool Settings::getStaticBatching() { return staticBatching; }
+
+bool Settings::getMultiDrawIndirect() { return multiDrawIndirect; }
+
+bool Settings::getAnimationLod() { return animationLod; }
+
+float Settings::getTimeWarp() { return timeWarp; }
+
+float Settings::getHitchFactor() { return hitchFactor; }
+
+RendererBackend Settings::getRenderer() { return renderer; }
+
+int Settings::getFrameLimit() { return frameLimit; }
+
+int Settings::getSimulateSteps() { return simulateSteps; }
+
+bool Settings::getOffscreen() { return offscreen; }
+
+const std::string& Settings::getDumpDirectory() { return dumpDirectory; }
+
+int Settings::getDumpInterval() { return dumpInterval; }
+
+const std::string& Settings::getBenchmarkPath() { return benchmarkPath; }
+
+const std::string& Settings::getTracePath() { return tracePath; }
+
+bool Settings::getCheckAllocations() { return checkAllocations; }
+
+int Settings::getSyntheticLights() { return syntheticLights; }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
-enum ViewMode { WIREFRAME, FLAT, SHADED };
+#include <string>
+
+enum ViewMode { WIREFRAME, FLAT, SHADED, OVERDRAW };
+
+enum RendererBackend { LEGACY, CORE };
 
 class Settings {
  private:
@@ -9,10 +13,40 @@ class Settings {
   bool showNormals = false;
   bool showAxis = true;
   bool isPaused = false;
+  bool staticBatching = true;
+  bool multiDrawIndirect = true;
+  bool animationLod = true;
+  float timeWarp = 1.0f;
+  float hitchFactor = 3.0f;
+  RendererBackend renderer = LEGACY;
+  int frameLimit = 0;
+  int syntheticLights = 0;
+  int simulateSteps = 0;
+  bool offscreen = false;
+  std::string dumpDirectory;
+  int dumpInterval = 0;
+  std::string benchmarkPath;
+  std::string tracePath;
+  bool checkAllocations = false;
   bool getShowAxis();
   void toggleNormals();
   void toggleViewmode();
   bool getShowNormals();
   bool getPaused();
+  bool getStaticBatching();
+  bool getMultiDrawIndirect();
+  bool getAnimationLod();
+  float getTimeWarp();
+  float getHitchFactor();
+  RendererBackend getRenderer();
+  int getFrameLimit();
+  int getSyntheticLights();
+  int getSimulateSteps();
+  bool getOffscreen();
+  const std::string& getDumpDirectory();
+  int getDumpInterval();
+  const std::string& getBenchmarkPath();
+  const std::string& getTracePath();
+  bool getCheckAllocations();
   ViewMode getViewmode();
 };
\ No newline at end of file
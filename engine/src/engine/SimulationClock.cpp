@@ -0,0 +1,45 @@
+#include "SimulationClock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Advances the simulation by a frame of real time.
+ *
+ * The real time, scaled by the warp factor, is accumulated and consumed in
+ * fixed steps, so the step count does not depend on the frame rate. The
+ * remainder is left in the accumulator for the next frame.
+ *
+ * At most maxSubsteps steps are taken per frame. When a hitch or a large warp
+ * would need more, the extra backlog is dropped instead of being caught up
+ * over the next frames, which would otherwise keep the frame time growing.
+ *
+ * @param realDelta The real time elapsed since the last frame, in seconds.
+ * @param warp How many simulated seconds pass per real second, 0 to pause.
+ * @return The number of fixed steps taken this frame.
+ */
+uint32_t SimulationClock::advance(double realDelta, double warp) {
+  accumulator += std::max(realDelta, 0.0) * std::max(warp, 0.0);
+
+  double pending = std::floor(accumulator / step);
+  if (pending > maxSubsteps) {
+    droppedTicks += static_cast<uint64_t>(pending) - maxSubsteps;
+    accumulator = std::fmod(accumulator, step) + maxSubsteps * step;
+    pending = maxSubsteps;
+  }
+
+  substeps = static_cast<uint32_t>(pending);
+  ticks += substeps;
+  accumulator = std::max(accumulator - substeps * step, 0.0);
+  return substeps;
+}
+
+/**
+ * @brief Rewinds the clock to time zero.
+ */
+void SimulationClock::reset() {
+  ticks = 0;
+  accumulator = 0.0;
+  substeps = 0;
+  droppedTicks = 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+class SimulationClock {
+ private:
+  double step;
+  uint32_t maxSubsteps;
+  uint64_t ticks = 0;
+  double accumulator = 0.0;
+  uint32_t substeps = 0;
+  uint64_t droppedTicks = 0;
+
+ public:
+  static constexpr double DEFAULT_STEP = 1.0 / 120.0;
+  static constexpr uint32_t DEFAULT_MAX_SUBSTEPS = 4096;
+
+  explicit SimulationClock(double step = DEFAULT_STEP,
+                           uint32_t maxSubsteps = DEFAULT_MAX_SUBSTEPS)
+      : step(step), maxSubsteps(maxSubsteps) {}
+
+  uint32_t advance(double realDelta, double warp);
+  void reset();
+
+  double getStep() const { return step; }
+  uint64_t getTicks() const { return ticks; }
+  double getTime() const { return static_cast<double>(ticks) * step; }
+  // All the warped time accumulated so far, including the part of a step
+  // not taken yet
+  double getWarpedTime() const { return getTime() + accumulator; }
+  uint32_t getSubsteps() const { return substeps; }
+  uint64_t getDroppedTicks() const { return droppedTicks; }
+};
@@ -1,27 +1,126 @@
+#include <cstdlib>
 #include <iostream>
 
+#include "debug/Allocations.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "engine/Engine.hpp"
 #include "settings.hpp"
 
 static debug::Logger logger;
 
+/**
+ * @brief Parses the command line options into the engine settings.
+ *
+ * Supported options are `--renderer legacy|core`, `--frames N`, which
+ * exits after N frames and logs their timings, `--synthetic-lights N`, which
+ * adds N point lights to the scene, and `--simulate N`, which runs N fixed
+ * update steps without a window and prints their timings as JSON.
+ * `--offscreen` renders into a framebuffer without a display, `--dump DIR`
+ * writes the last frame there as a PPM image and `--dump-interval N` also
+ * writes every Nth frame. `--benchmark FILE` orbits the camera around its
+ * target with a fixed time step and writes the frame times, render counters
+ * and memory of the run to FILE as JSON. `--trace FILE` enables
+ * the profiler and writes its zones to FILE as a Chrome trace on exit.
+ * `--check-allocations` fails the run if any frame after the warmup
+ * allocates from the heap. The scene file is given with `--scene` or as the
+ * remaining argument.
+ *
+ * @return false if an option is invalid.
+ */
+static bool parseArguments(int argc, char* argv[], Settings& settings,
+                           string& filename) {
+  for (int i = 1; i < argc; i++) {
+    string argument = argv[i];
+
+    if (argument == "--renderer" && i + 1 < argc) {
+      string renderer = argv[++i];
+      if (renderer == "legacy") {
+        settings.renderer = LEGACY;
+      } else if (renderer == "core") {
+        settings.renderer = CORE;
+      } else {
+        logger.error("Unknown renderer: " + renderer + ".");
+        return false;
+      }
+    } else if (argument == "--frames" && i + 1 < argc) {
+      settings.frameLimit = std::atoi(argv[++i]);
+    } else if (argument == "--synthetic-lights" && i + 1 < argc) {
+      settings.syntheticLights = std::atoi(argv[++i]);
+    } else if (argument == "--simulate" && i + 1 < argc) {
+      settings.simulateSteps = std::atoi(argv[++i]);
+    } else if (argument == "--scene" && i + 1 < argc) {
+      filename = argv[++i];
+    } else if (argument == "--offscreen") {
+      settings.offscreen = true;
+    } else if (argument == "--dump" && i + 1 < argc) {
+      settings.dumpDirectory = argv[++i];
+    } else if (argument == "--dump-interval" && i + 1 < argc) {
+      settings.dumpInterval = std::atoi(argv[++i]);
+    } else if (argument == "--benchmark" && i + 1 < argc) {
+      settings.benchmarkPath = argv[++i];
+    } else if (argument == "--trace" && i + 1 < argc) {
+      settings.tracePath = argv[++i];
+      debug::Profiler::setEnabled(true);
+    } else if (argument == "--check-allocations") {
+      if (!debug::AllocationTracker::isCompiledIn()) {
+        logger.error("Allocation tracking is compiled out of this build.");
+        return false;
+      }
+      settings.checkAllocations = true;
+    } else if (argument.rfind("--", 0) == 0) {
+      logger.error("Unknown option: " + argument + ".");
+      return false;
+    } else {
+      filename = argument;
+    }
+  }
+
+  if ((!settings.benchmarkPath.empty() || settings.checkAllocations) &&
+      settings.frameLimit <= 0) {
+    settings.frameLimit = 300;
+  }
+
+  if (settings.offscreen && settings.frameLimit <= 0) {
+    // Nothing can close an offscreen run but the frame limit
+    settings.frameLimit = 1;
+  }
+
+  return true;
+}
+
 int main(const int argc, char *argv[]) {
   Engine engine;
+  string filename;
+
+  if (!parseArguments(argc, argv, *engine.getSettings(), filename)) {
+    return -1;
+  }
+
+  if (engine.getSettings()->getSimulateSteps() > 0) {
+    if (filename.empty()) {
+      logger.error("--simulate needs a scene file.");
+      return -1;
+    }
+    return engine.simulate(filename, engine.getSettings()->getSimulateSteps())
+               ? 0
+               : -1;
+  }
 
-  if (argc == 1) {
+  if (filename.empty()) {
     logger.info("Loading default empty scene.");
     if (!engine.initialize()) {
       return -1;
     }
   } else {
-    logger.info("Loading scene from file: " + string(argv[1]) + ".");
-    if (!engine.initializeFromFile(argv[1])) {
+    logger.info("Loading scene from file: " + filename + ".");
+    if (!engine.initializeFromFile(filename)) {
       return -1;
     }
   }
 
   engine.run();
 
-  return 0;
-}
\ No newline at end of file
+  logger.flush();
+  return engine.getAllocationCheckPassed() ? 0 : -1;
+}
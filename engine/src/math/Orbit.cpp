@@ -0,0 +1,117 @@
+#include "Orbit.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "render/DebugDraw.hpp"
+
+static constexpr float TWO_PI = 6.28318530718f;
+static constexpr int KEPLER_ITERATIONS = 8;
+
+/**
+ * @brief Creates a Kepler orbit around the origin of the parent space.
+ *
+ * The orbit lies in the XZ plane, tilted around the X axis by the
+ * inclination, with the focus at the origin and the periapsis on +X.
+ *
+ * @param radius The semi-major axis.
+ * @param eccentricity The eccentricity, clamped to [0, 0.99].
+ * @param inclination The inclination in degrees.
+ * @param period The time of one revolution, 0 for a fixed position.
+ * @param phase The mean anomaly at time 0, in degrees.
+ * @param render_path Whether to draw the orbit trail.
+ */
+Orbit::Orbit(float radius, float eccentricity, float inclination,
+             float period, float phase, bool render_path)
+    : radius(radius),
+      eccentricity(std::clamp(eccentricity, 0.0f, 0.99f)),
+      inclination(inclination),
+      period(period),
+      phase(phase),
+      render_path(render_path) {
+  semiMinorAxis =
+      radius * std::sqrt(1.0f - this->eccentricity * this->eccentricity);
+  cosInclination = std::cos(glm::radians(inclination));
+  sinInclination = std::sin(glm::radians(inclination));
+}
+
+/**
+ * @brief Solves Kepler's equation M = E - e sin(E) for the eccentric anomaly.
+ *
+ * Circular orbits are solved exactly, elliptic ones with Newton iterations
+ * that converge in a few steps for the eccentricities scenes use.
+ *
+ * @param meanAnomaly The mean anomaly in radians.
+ * @return The eccentric anomaly in radians.
+ */
+float Orbit::solveKepler(float meanAnomaly) const {
+  if (eccentricity == 0.0f) {
+    return meanAnomaly;
+  }
+
+  float anomaly = eccentricity > 0.8f ? TWO_PI * 0.5f : meanAnomaly;
+  for (int i = 0; i < KEPLER_ITERATIONS; i++) {
+    float delta =
+        (anomaly - eccentricity * std::sin(anomaly) - meanAnomaly) /
+        (1.0f - eccentricity * std::cos(anomaly));
+    anomaly -= delta;
+    if (std::abs(delta) < 1e-6f) {
+      break;
+    }
+  }
+  return anomaly;
+}
+
+/**
+ * @brief Returns the position on the orbit at an eccentric anomaly.
+ *
+ * The orbit runs from +X towards -Z, like the sampled circular paths it
+ * replaces.
+ *
+ * @param eccentricAnomaly The eccentric anomaly in radians.
+ * @return The position in the parent space.
+ */
+vec3 Orbit::getPosition(float eccentricAnomaly) const {
+  float x = radius * (std::cos(eccentricAnomaly) - eccentricity);
+  float z = -semiMinorAxis * std::sin(eccentricAnomaly);
+  return vec3(x, -z * sinInclination, z * cosInclination);
+}
+
+glm::mat4 Orbit::apply(const glm::mat4& matrix, double time) const {
+  float meanAnomaly = glm::radians(phase);
+  if (period != 0.0f) {
+    double revolutions = time / period;
+    meanAnomaly +=
+        TWO_PI * static_cast<float>(revolutions - std::floor(revolutions));
+  }
+
+  vec3 position = getPosition(solveKepler(meanAnomaly));
+
+  // Like paths, orbits translate in the parent space
+  return glm::translate(glm::mat4(1.0f), position) * matrix;
+}
+
+/**
+ * @brief Draws the orbit trail as a line loop.
+ *
+ * The ellipse is sampled and uploaded on first use only.
+ *
+ * @param modelView The model view matrix of the parent space.
+ */
+void Orbit::renderDebug(const glm::mat4& modelView) const {
+  if (!render_path) {
+    return;
+  }
+
+  if (lines == DebugDraw::INVALID_LINES) {
+    std::vector<vec3> polyline;
+    polyline.reserve(TRAIL_SEGMENTS);
+    for (int i = 0; i < TRAIL_SEGMENTS; i++) {
+      polyline.push_back(getPosition(TWO_PI * i / TRAIL_SEGMENTS));
+    }
+    lines = DebugDraw::createLines(polyline, GL_LINE_LOOP);
+  }
+
+  DebugDraw::drawLines(lines, modelView, vec3(1.0f));
+}
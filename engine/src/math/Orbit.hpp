@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Transformation.hpp"
+
+using glm::vec3;
+
+class Orbit : public Transformation {
+ private:
+  static constexpr int TRAIL_SEGMENTS = 128;
+
+  float semiMinorAxis;
+  float cosInclination;
+  float sinInclination;
+  mutable uint32_t lines = UINT32_MAX;
+
+  vec3 getPosition(float eccentricAnomaly) const;
+  float solveKepler(float meanAnomaly) const;
+
+ public:
+  float radius, eccentricity, inclination, period, phase;
+  bool render_path;
+
+  Orbit(float radius, float eccentricity, float inclination, float period,
+        float phase, bool render_path);
+  glm::mat4 apply(const glm::mat4& matrix, double time) const override;
+  void renderDebug(const glm::mat4& modelView) const override;
+  bool isStatic() const override { return period == 0.0f; }
+};
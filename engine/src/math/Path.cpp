@@ -1,13 +1,97 @@
 #include "Path.hpp"
 
-#include <GL/glew.h>
-
+#include <algorithm>
+#include <cmath>
 #include <glm/glm.hpp>
 #include <iostream>
-#define GLFW_INCLUDE_GLU
-#include <GLFW/glfw3.h>
 
-glm::mat4 Path::apply(const glm::mat4& matrix, float time) const {
+#include "render/DebugDraw.hpp"
+
+Path::Path(float duration, bool align, const std::vector<vec3>& path_points,
+           bool render_path, bool constant_speed)
+    : duration(duration),
+      align(align),
+      path_points(path_points),
+      render_path(render_path),
+      constant_speed(constant_speed) {
+  buildSegments();
+  if (constant_speed) {
+    buildArcLengths();
+  }
+}
+
+/**
+ * @brief Expands the Catmull-Rom basis into polynomial coefficients.
+ *
+ * The curve is closed, segment i goes from point i to point i + 1 and is
+ * evaluated as ((a * t + b) * t + c) * t + d, so no basis matrix or modulo
+ * indexing is needed per evaluation.
+ */
+void Path::buildSegments() {
+  int point_count = path_points.size();
+  segments.resize(point_count);
+
+  for (int i = 0; i < point_count; i++) {
+    const vec3& p0 = path_points[(i + point_count - 1) % point_count];
+    const vec3& p1 = path_points[i];
+    const vec3& p2 = path_points[(i + 1) % point_count];
+    const vec3& p3 = path_points[(i + 2) % point_count];
+
+    PathSegment& segment = segments[i];
+    segment.a = -0.5f * p0 + 1.5f * p1 - 1.5f * p2 + 0.5f * p3;
+    segment.b = p0 - 2.5f * p1 + 2.0f * p2 - 0.5f * p3;
+    segment.c = -0.5f * p0 + 0.5f * p2;
+    segment.d = p1;
+  }
+}
+
+/**
+ * @brief Samples the cumulative arc length of the curve.
+ *
+ * Each segment is split into ARC_LENGTH_SAMPLES chords. Entry k holds the
+ * length of the curve up to parameter k / (segments * ARC_LENGTH_SAMPLES).
+ */
+void Path::buildArcLengths() {
+  int samples = segments.size() * ARC_LENGTH_SAMPLES;
+  arcLengths.resize(samples + 1);
+  arcLengths[0] = 0.0f;
+
+  vec3 derivative;
+  vec3 previous = GetCurvePosition(0.0f, derivative);
+  for (int k = 1; k <= samples; k++) {
+    float parameter = static_cast<float>(k) / static_cast<float>(samples);
+    vec3 position = GetCurvePosition(parameter, derivative);
+    arcLengths[k] = arcLengths[k - 1] + glm::length(position - previous);
+    previous = position;
+  }
+}
+
+/**
+ * @brief Maps a normalized time to the curve parameter at that distance.
+ *
+ * The travelled distance is found in the arc length table with a binary
+ * search and interpolated linearly between the two surrounding samples.
+ *
+ * @param time The normalized time, in [0, 1).
+ * @return The curve parameter, in [0, 1).
+ */
+float Path::toCurveParameter(float time) const {
+  float total = arcLengths.back();
+  if (total <= 0.0f) {
+    return time;
+  }
+
+  float distance = time * total;
+  auto upper = std::upper_bound(arcLengths.begin(), arcLengths.end(), distance);
+  int k = std::clamp(static_cast<int>(upper - arcLengths.begin()) - 1, 0,
+                     static_cast<int>(arcLengths.size()) - 2);
+
+  float span = arcLengths[k + 1] - arcLengths[k];
+  float fraction = span > 0.0f ? (distance - arcLengths[k]) / span : 0.0f;
+  return (k + fraction) / static_cast<float>(arcLengths.size() - 1);
+}
+
+glm::mat4 Path::apply(const glm::mat4& matrix, double time) const {
   vec3 derivative;
   vec3 position = GetPathPosition(time / duration, derivative);
   glm::mat4 result = glm::translate(glm::mat4(1.0f), position);
@@ -26,53 +110,81 @@ glm::mat4 Path::apply(const glm::mat4& matrix, float time) const {
     result *= rotation_matrix;
   }
 
-  if (render_path) {
-    glBegin(GL_LINE_LOOP);
+  return result * matrix;
+}
+
+/**
+ * @brief Draws the curve of the path as a line loop.
+ *
+ * The curve is sampled and uploaded on first use only, the control points do
+ * not change once the scene is loaded.
+ *
+ * @param modelView The model view matrix of the space the path is defined in.
+ */
+void Path::renderDebug(const glm::mat4& modelView) const {
+  if (!render_path) {
+    return;
+  }
 
+  if (lines == DebugDraw::INVALID_LINES) {
     const size_t segments = 100;
 
+    std::vector<vec3> polyline;
+    polyline.reserve(segments);
     for (int i = 0; i < segments; ++i) {
       const float time = static_cast<float>(i) / static_cast<float>(segments);
       vec3 derivative;
-      vec3 position = GetPathPosition(time, derivative);
-      glVertex3f(position.x, position.y, position.z);
+      polyline.push_back(GetCurvePosition(time, derivative));
     }
-    glEnd();
+    lines = DebugDraw::createLines(polyline, GL_LINE_LOOP);
   }
 
-  return result * matrix;
+  DebugDraw::drawLines(lines, modelView, vec3(1.0f));
 }
 
-glm::vec3 Path::GetPathPosition(float time, vec3& derivative) const {
-  glm::vec3 position;
+/**
+ * @brief Evaluates the curve at a parameter.
+ *
+ * @param parameter The curve parameter, in [0, 1).
+ * @param derivative Receives the derivative along the current segment.
+ * @return The position on the curve.
+ */
+glm::vec3 Path::GetCurvePosition(float parameter, vec3& derivative) const {
+  if (segments.empty()) {
+    derivative = vec3(1.0f, 0.0f, 0.0f);
+    return vec3(0.0f);
+  }
 
-  int point_count = path_points.size();
-  float t = time * point_count;
-  int i = floor(t);
+  int segment_count = segments.size();
+  float t = parameter * segment_count;
+  int i = std::min(static_cast<int>(t), segment_count - 1);
   float time_in_segment = t - i;
 
-  const glm::vec3& p0 = path_points[(i + point_count - 1) % point_count];
-  const glm::vec3& p1 = path_points[i % point_count];
-  const glm::vec3& p2 = path_points[(i + 1) % point_count];
-  const glm::vec3& p3 = path_points[(i + 2) % point_count];
-
-  glm::mat4 catmull_matrix = glm::transpose(
-      glm::mat4(-0.5f, 1.5f, -1.5f, 0.5f, 1.0f, -2.5f, 2.0f, -0.5f, -0.5f, 0.0f,
-                0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f));
-
-  glm::vec4 time_vector =
-      glm::vec4(time_in_segment * time_in_segment * time_in_segment,
-                time_in_segment * time_in_segment, time_in_segment, 1.0f);
-  glm::vec4 time_derivative = glm::vec4(3 * time_in_segment * time_in_segment,
-                                        2 * time_in_segment, 1.0f, 0.0f);
-
-  for (int j = 0; j < 3; j++) {
-    glm::vec4 p = glm::vec4(p0[j], p1[j], p2[j], p3[j]);
-    glm::vec4 result = catmull_matrix * p;
+  const PathSegment& segment = segments[i];
+  derivative = (3.0f * segment.a * time_in_segment + 2.0f * segment.b) *
+                   time_in_segment +
+               segment.c;
+  return ((segment.a * time_in_segment + segment.b) * time_in_segment +
+          segment.c) *
+             time_in_segment +
+         segment.d;
+}
 
-    position[j] = glm::dot(result, time_vector);
-    derivative[j] = glm::dot(result, time_derivative);
+/**
+ * @brief Evaluates the path at a normalized time.
+ *
+ * Times outside [0, 1) wrap around the closed curve. With constant_speed the
+ * time is remapped through the arc length table so the object moves at the
+ * same speed regardless of the spacing of the control points.
+ *
+ * @param time The normalized time.
+ * @param derivative Receives the derivative along the current segment.
+ * @return The position on the path.
+ */
+glm::vec3 Path::GetPathPosition(double time, vec3& derivative) const {
+  float parameter = static_cast<float>(time - std::floor(time));
+  if (constant_speed) {
+    parameter = toCurveParameter(parameter);
   }
-
-  return position;
-}
\ No newline at end of file
+  return GetCurvePosition(parameter, derivative);
+}
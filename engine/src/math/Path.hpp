@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <glm/glm.hpp>
 
 #include "Transformation.hpp"
@@ -6,22 +7,38 @@
 using glm::vec3;
 using glm::vec4;
 
+struct PathSegment {
+  vec3 a;
+  vec3 b;
+  vec3 c;
+  vec3 d;
+};
+
 class Path : public Transformation {
  private:
-  vec3 GetPathPosition(float time, vec3& derivative) const;
+  static constexpr int ARC_LENGTH_SAMPLES = 16;
+
+  std::vector<PathSegment> segments;
+  std::vector<float> arcLengths;
+  mutable uint32_t lines = UINT32_MAX;
+
+  void buildSegments();
+  void buildArcLengths();
+  float toCurveParameter(float time) const;
+  vec3 GetCurvePosition(float parameter, vec3& derivative) const;
 
  public:
   float duration;
   bool align;
   std::vector<vec3> path_points;
   bool render_path;
+  bool constant_speed;
   mutable vec3 last_y_axis = glm::vec3(0, 1, 0);
 
   Path(float duration, bool align, const std::vector<vec3>& path_points,
-       bool render_path)
-      : duration(duration),
-        align(align),
-        path_points(path_points),
-        render_path(render_path) {}
-  glm::mat4 apply(const glm::mat4& matrix, float time) const override;
+       bool render_path, bool constant_speed = false);
+  vec3 GetPathPosition(double time, vec3& derivative) const;
+  glm::mat4 apply(const glm::mat4& matrix, double time) const override;
+  void renderDebug(const glm::mat4& modelView) const override;
+  bool isStatic() const override { return false; }
 };
\ No newline at end of file
@@ -3,18 +3,22 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#include <cmath>
+
 class Rotate : public Transformation {
  public:
   float angle, duration, x, y, z;
   Rotate(float angle, float duration, float x, float y, float z)
       : angle(angle), duration(duration), x(x), y(y), z(z) {}
-  glm::mat4 apply(const glm::mat4& matrix, float time) const override {
+  glm::mat4 apply(const glm::mat4& matrix, double time) const override {
     if (duration != 0.0f) {
-      // Rotation over time
-      float angle = static_cast<float>(time * M_PI * 2 / duration);
+      // Rotation over time, wrapped in double so long runs keep precision
+      float angle = static_cast<float>(std::fmod(time, duration) * M_PI * 2 /
+                                       duration);
       return glm::rotate(matrix, angle, glm::vec3(x, y, z));
     }
     // Static rotation
     return glm::rotate(matrix, glm::radians(angle), glm::vec3(x, y, z));
   }
+  bool isStatic() const override { return duration == 0.0f; }
 };
\ No newline at end of file
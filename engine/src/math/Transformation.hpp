@@ -4,6 +4,8 @@
 
 class Transformation {
  public:
-  virtual glm::mat4 apply(const glm::mat4& matrix, float time) const = 0;
+  virtual glm::mat4 apply(const glm::mat4& matrix, double time) const = 0;
+  virtual void renderDebug(const glm::mat4& modelView) const {}
+  virtual bool isStatic() const { return true; }
   virtual ~Transformation() = default;
 };
\ No newline at end of file
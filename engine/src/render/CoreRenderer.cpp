@@ -0,0 +1,528 @@
+#include "CoreRenderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GeometryHeap.hpp"
+#include "Shader.hpp"
+#include "StateCache.hpp"
+#include "debug/Logger.hpp"
+#include "scene/Light.hpp"
+#include "scene/Model.hpp"
+
+static debug::Logger logger;
+
+static constexpr GLuint CAMERA_BINDING = 0;
+static constexpr GLuint MATERIAL_BINDING = 1;
+
+// Attribute locations of the per-draw transform, one per matrix column
+static constexpr GLuint MODEL_VIEW_ATTRIBUTE = 3;
+static constexpr GLuint NORMAL_MATRIX_ATTRIBUTE = 7;
+
+// Texture units, the diffuse texture always uses unit 0
+static constexpr GLint LIGHT_DATA_UNIT = 1;
+static constexpr GLint CLUSTER_RANGES_UNIT = 2;
+static constexpr GLint LIGHT_INDICES_UNIT = 3;
+
+static TextureBuffer createTextureBuffer(GLenum format) {
+  TextureBuffer textureBuffer;
+  glGenBuffers(1, &textureBuffer.buffer);
+  glBindBuffer(GL_TEXTURE_BUFFER, textureBuffer.buffer);
+  glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+  glGenTextures(1, &textureBuffer.texture);
+  glBindTexture(GL_TEXTURE_BUFFER, textureBuffer.texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, format, textureBuffer.buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  return textureBuffer;
+}
+
+/**
+ * @brief Replaces the contents of a texture buffer.
+ *
+ * The storage is respecified every frame so the driver can hand out fresh
+ * memory instead of waiting on draws still reading the previous frame.
+ */
+static void uploadTextureBuffer(const TextureBuffer& textureBuffer,
+                                const void* data, size_t bytes) {
+  StateCache::bindBuffer(GL_TEXTURE_BUFFER, textureBuffer.buffer);
+  glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(bytes, 16), nullptr,
+               GL_STREAM_DRAW);
+  if (bytes > 0) {
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+  }
+}
+
+static void bindTextureBuffer(GLint unit, const TextureBuffer& textureBuffer) {
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_BUFFER, textureBuffer.texture);
+}
+
+static void bindUniformBlock(GLuint program, const char* name,
+                             GLuint binding) {
+  GLuint index = glGetUniformBlockIndex(program, name);
+  if (index != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program, index, binding);
+  }
+}
+
+/**
+ * @brief Compiles the mesh shaders and creates the uniform buffers.
+ *
+ * Must be called once the core profile context is current.
+ *
+ * @param vertexPath The path of the vertex shader.
+ * @param fragmentPath The path of the fragment shader.
+ * @return true if the shaders were compiled and linked.
+ */
+bool CoreRenderer::initialize(const std::string& vertexPath,
+                              const std::string& fragmentPath) {
+  program = loadProgram(vertexPath, fragmentPath);
+  if (program == 0) {
+    return false;
+  }
+
+  bindUniformBlock(program, "Camera", CAMERA_BINDING);
+  bindUniformBlock(program, "Material", MATERIAL_BINDING);
+
+  litLocation = glGetUniformLocation(program, "lit");
+  texturedLocation = glGetUniformLocation(program, "textured");
+  globalLightCountLocation = glGetUniformLocation(program, "globalLightCount");
+  viewportSizeLocation = glGetUniformLocation(program, "viewportSize");
+  clusterDepthLocation = glGetUniformLocation(program, "clusterDepth");
+
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "diffuseTexture"), 0);
+  glUniform1i(glGetUniformLocation(program, "lightData"), LIGHT_DATA_UNIT);
+  glUniform1i(glGetUniformLocation(program, "clusterRanges"),
+              CLUSTER_RANGES_UNIT);
+  glUniform1i(glGetUniformLocation(program, "lightIndices"),
+              LIGHT_INDICES_UNIT);
+  glUseProgram(0);
+
+  GLint alignment;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  materialStride = static_cast<GLint>(
+      (sizeof(CoreMaterial) + alignment - 1) / alignment * alignment);
+
+  glGenBuffers(1, &cameraBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, cameraBuffer);
+
+  lightBuffer = createTextureBuffer(GL_RGBA32F);
+  clusterBuffer = createTextureBuffer(GL_RG32UI);
+  indexBuffer = createTextureBuffer(GL_R32UI);
+  StateCache::invalidate();
+
+  glGenBuffers(1, &materialBuffer);
+  uploadedMaterials = 0;
+
+  glGenBuffers(1, &transformBuffer);
+
+  logger.info("Core profile renderer initialized.");
+  return true;
+}
+
+/**
+ * @brief Forgets all GL objects.
+ *
+ * This does not delete them, it must be called once the GL context owning
+ * them has been destroyed.
+ */
+void CoreRenderer::reset() {
+  program = 0;
+  vertexArray = 0;
+  vertexArrayVertices = 0;
+  vertexArrayIndices = 0;
+  transformBuffer = 0;
+  cameraBuffer = 0;
+  materialBuffer = 0;
+  uploadedMaterials = 0;
+  lightBuffer = TextureBuffer();
+  clusterBuffer = TextureBuffer();
+  indexBuffer = TextureBuffer();
+}
+
+/**
+ * @brief Uploads the camera matrices and updates the light cluster grid.
+ *
+ * @param view The camera view matrix.
+ * @param projection The camera projection matrix.
+ * @param viewportSize The size of the viewport in pixels.
+ */
+void CoreRenderer::setCamera(const glm::mat4& view,
+                             const glm::mat4& projection,
+                             const glm::vec2& viewportSize) {
+  glm::mat4 camera[2] = {view, projection};
+  glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera), camera);
+
+  clusters.setProjection(projection);
+  this->viewportSize = viewportSize;
+}
+
+/**
+ * @brief Bins the scene lights into the cluster grid, in view space.
+ *
+ * Lights with a range are binned into every cluster their sphere touches.
+ * Directional lights and lights without a range reach every fragment, so
+ * they are stored first and looped over everywhere instead.
+ *
+ * @param lights The lights of the scene.
+ * @param view The camera view matrix.
+ */
+void CoreRenderer::setLights(std::vector<Light>& lights,
+                             const glm::mat4& view) {
+  auto start = std::chrono::steady_clock::now();
+
+  lightData.clear();
+  clusterLights.clear();
+
+  for (int pass = 0; pass < 2; pass++) {
+    for (Light& light : lights) {
+      bool bounded = light.getType() != DIRECTIONAL && light.getRange() > 0.0f;
+      if (bounded != (pass == 1)) {
+        continue;
+      }
+
+      CoreLight coreLight;
+      coreLight.color = glm::vec4(light.getColor(), light.getRange());
+      coreLight.direction = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+
+      switch (light.getType()) {
+        case DIRECTIONAL:
+          coreLight.position = view * glm::vec4(light.getDirection(), 0.0f);
+          coreLight.color.w = 0.0f;
+          break;
+        case POINT:
+          coreLight.position = view * glm::vec4(light.getPosition(), 1.0f);
+          break;
+        case SPOTLIGHT:
+          coreLight.position = view * glm::vec4(light.getPosition(), 1.0f);
+          coreLight.direction = glm::vec4(
+              glm::normalize(glm::mat3(view) * light.getDirection()),
+              glm::cos(glm::radians(light.getCutoff())));
+          break;
+        default:
+          break;
+      }
+
+      if (bounded) {
+        clusterLights.push_back(
+            {glm::vec3(coreLight.position), light.getRange()});
+      }
+      lightData.push_back(coreLight);
+    }
+
+    if (pass == 0) {
+      globalLightCount = static_cast<uint32_t>(lightData.size());
+    }
+  }
+
+  clusters.build(clusterLights);
+
+  auto end = std::chrono::steady_clock::now();
+  binningMilliseconds =
+      std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * @brief Uploads the light data and the per-cluster light lists.
+ *
+ * Cluster light indices are relative to the bounded lights, which are stored
+ * right after the global ones.
+ */
+void CoreRenderer::uploadLights() {
+  uploadTextureBuffer(lightBuffer, lightData.data(),
+                      lightData.size() * sizeof(CoreLight));
+  uploadTextureBuffer(clusterBuffer, clusters.getRanges().data(),
+                      clusters.getRanges().size() * sizeof(ClusterRange));
+  uploadTextureBuffer(indexBuffer, clusters.getIndices().data(),
+                      clusters.getIndices().size() * sizeof(uint32_t));
+
+  bindTextureBuffer(LIGHT_DATA_UNIT, lightBuffer);
+  bindTextureBuffer(CLUSTER_RANGES_UNIT, clusterBuffer);
+  bindTextureBuffer(LIGHT_INDICES_UNIT, indexBuffer);
+  glActiveTexture(GL_TEXTURE0);
+
+  glUniform1i(globalLightCountLocation, static_cast<GLint>(globalLightCount));
+  glUniform2f(viewportSizeLocation, viewportSize.x, viewportSize.y);
+  glUniform2f(clusterDepthLocation, clusters.getNear(),
+              LightClusters::GRID_Z /
+                  std::log(clusters.getFar() / clusters.getNear()));
+}
+
+/**
+ * @brief Uploads the interned materials, once per new material.
+ *
+ * Every material lives at its own aligned offset of a single uniform buffer,
+ * so changing material is a glBindBufferRange instead of an upload.
+ */
+void CoreRenderer::uploadMaterials() {
+  const std::vector<Material>& materials = getMaterials();
+  if (materials.size() == uploadedMaterials) {
+    return;
+  }
+
+  std::vector<uint8_t> data(materials.size() * materialStride);
+  for (size_t i = 0; i < materials.size(); i++) {
+    const Material& material = materials[i];
+    CoreMaterial coreMaterial = {};
+    coreMaterial.ambient = glm::vec4(material.ambient, 1.0f);
+    coreMaterial.diffuse = glm::vec4(material.diffuse, 1.0f);
+    coreMaterial.specular = glm::vec4(material.specular, 1.0f);
+    coreMaterial.emission = glm::vec4(material.emission, 1.0f);
+    coreMaterial.shininess = material.shininess;
+    memcpy(&data[i * materialStride], &coreMaterial, sizeof(coreMaterial));
+  }
+
+  StateCache::bindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+  uploadedMaterials = materials.size();
+}
+
+/**
+ * @brief Writes the transform of every draw of the queue and uploads them.
+ *
+ * The normal matrices are computed here once per transform instead of per
+ * vertex in the shader.
+ *
+ * @param queue The render queue of the frame.
+ */
+void CoreRenderer::uploadTransforms(const RenderQueue& queue) {
+  instanceTransforms.resize(queue.getTransformCount());
+  for (size_t i = 0; i < instanceTransforms.size(); i++) {
+    InstanceTransform& transform = instanceTransforms[i];
+    transform.modelView = queue.getTransform(static_cast<uint32_t>(i));
+    glm::mat3 normalMatrix =
+        glm::inverseTranspose(glm::mat3(transform.modelView));
+    for (int column = 0; column < 3; column++) {
+      transform.normalMatrix[column] = normalMatrix[column];
+    }
+  }
+
+  StateCache::bindBuffer(GL_ARRAY_BUFFER, transformBuffer);
+  glBufferData(GL_ARRAY_BUFFER,
+               instanceTransforms.size() * sizeof(InstanceTransform),
+               instanceTransforms.data(), GL_STREAM_DRAW);
+}
+
+/**
+ * @brief Sets the transform of the following draws when the instanced
+ * transform attributes are disabled.
+ *
+ * @param modelView The modelview matrix of the draws.
+ */
+void CoreRenderer::setTransform(const glm::mat4& modelView) {
+  glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(modelView));
+  for (int column = 0; column < 4; column++) {
+    glVertexAttrib4fv(MODEL_VIEW_ATTRIBUTE + column,
+                      glm::value_ptr(modelView[column]));
+  }
+  for (int column = 0; column < 3; column++) {
+    glVertexAttrib3fv(NORMAL_MATRIX_ATTRIBUTE + column,
+                      glm::value_ptr(normalMatrix[column]));
+  }
+}
+
+/**
+ * @brief Binds the vertex array describing the GeometryHeap arenas.
+ *
+ * Every mesh lives in the same interleaved arenas, so a single vertex array
+ * serves the whole scene. It is only respecified when the heap reallocates
+ * its buffers. The transform attributes advance once per instance, so the
+ * base instance of an indirect command picks the transform of its draw.
+ */
+void CoreRenderer::bindGeometry() {
+  if (vertexArray == 0) {
+    glGenVertexArrays(1, &vertexArray);
+  }
+  glBindVertexArray(vertexArray);
+
+  GLuint vertices = GeometryHeap::getVertexBuffer();
+  GLuint indices = GeometryHeap::getIndexBuffer();
+  if (vertices == vertexArrayVertices && indices == vertexArrayIndices) {
+    return;
+  }
+
+  // The element array binding is vertex array state, not tracked by the cache
+  glBindBuffer(GL_ARRAY_BUFFER, vertices);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(
+      0, 3, GL_FLOAT, GL_FALSE, sizeof(HeapVertex),
+      reinterpret_cast<void*>(offsetof(HeapVertex, position)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(HeapVertex),
+                        reinterpret_cast<void*>(offsetof(HeapVertex, normal)));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(
+      2, 2, GL_FLOAT, GL_FALSE, sizeof(HeapVertex),
+      reinterpret_cast<void*>(offsetof(HeapVertex, texCoord)));
+
+  glBindBuffer(GL_ARRAY_BUFFER, transformBuffer);
+  for (GLuint column = 0; column < 4; column++) {
+    glVertexAttribPointer(
+        MODEL_VIEW_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE,
+        sizeof(InstanceTransform),
+        reinterpret_cast<void*>(offsetof(InstanceTransform, modelView) +
+                                column * sizeof(glm::vec4)));
+    glVertexAttribDivisor(MODEL_VIEW_ATTRIBUTE + column, 1);
+  }
+  for (GLuint column = 0; column < 3; column++) {
+    glVertexAttribPointer(
+        NORMAL_MATRIX_ATTRIBUTE + column, 3, GL_FLOAT, GL_FALSE,
+        sizeof(InstanceTransform),
+        reinterpret_cast<void*>(offsetof(InstanceTransform, normalMatrix) +
+                                column * sizeof(glm::vec3)));
+    glVertexAttribDivisor(NORMAL_MATRIX_ATTRIBUTE + column, 1);
+  }
+  StateCache::invalidate();
+
+  vertexArrayVertices = vertices;
+  vertexArrayIndices = indices;
+}
+
+/**
+ * @brief Draws the sorted packets of a render queue with the mesh shaders.
+ *
+ * Materials are switched with a buffer range bind and textures through the
+ * StateCache. WIREFRAME and FLAT draw unlit, SHADED evaluates the lights per
+ * fragment.
+ *
+ * With multi-draw indirect, the transforms of the frame are uploaded once and
+ * read per draw through the base instance of its command, so consecutive
+ * packets sharing their material and texture are drawn by a single
+ * glMultiDrawElementsIndirect call whatever group they belong to. Otherwise
+ * the transform is set as a constant attribute whenever it changes.
+ *
+ * @param queue The sorted render queue.
+ * @param useMultiDraw Whether to use multi-draw indirect when supported.
+ */
+void CoreRenderer::submit(RenderQueue& queue, bool useMultiDraw) {
+  auto start = std::chrono::steady_clock::now();
+
+  stats = queue.getStats();
+  stats.lights = static_cast<uint32_t>(lightData.size());
+  stats.lightBinningMilliseconds = binningMilliseconds;
+  stats.maxClusterLights = clusters.getMaxClusterLights();
+  // The most lights a fragment can evaluate
+  stats.activeLights = globalLightCount + stats.maxClusterLights;
+  stats.multiDrawIndirect =
+      useMultiDraw && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) &&
+      (GLEW_VERSION_4_2 || GLEW_ARB_base_instance);
+
+  if (program == 0 || GeometryHeap::getVertexBuffer() == 0) {
+    return;
+  }
+
+  uint32_t bufferBinds = StateCache::getBufferBinds();
+  uint32_t textureBinds = StateCache::getTextureBinds();
+
+  uploadMaterials();
+
+  glUseProgram(program);
+  uploadLights();
+  bindGeometry();
+  glUniform1i(litLocation, queue.getViewMode() == SHADED);
+
+  const std::vector<DrawPacket>& packets = queue.getPackets();
+
+  // Both matrices occupy consecutive locations
+  for (GLuint attribute = MODEL_VIEW_ATTRIBUTE;
+       attribute < NORMAL_MATRIX_ATTRIBUTE + 3; attribute++) {
+    if (stats.multiDrawIndirect) {
+      glEnableVertexAttribArray(attribute);
+    } else {
+      glDisableVertexAttribArray(attribute);
+    }
+  }
+
+  if (stats.multiDrawIndirect && !packets.empty()) {
+    uploadTransforms(queue);
+    queue.uploadCommands();
+  }
+
+  int currentMaterial = -1;
+  int64_t currentTexture = -1;
+  int64_t currentTransform = -1;
+
+  size_t i = 0;
+  while (i < packets.size()) {
+    const DrawPacket& packet = packets[i];
+    const Model& model = *packet.model;
+    uint32_t texture =
+        model.usesTexture(queue.getViewMode()) ? model.getTextureId() : 0;
+
+    size_t runEnd = i + 1;
+    while (stats.multiDrawIndirect && runEnd < packets.size()) {
+      const Model& next = *packets[runEnd].model;
+      uint32_t nextTexture =
+          next.usesTexture(queue.getViewMode()) ? next.getTextureId() : 0;
+      if (next.getMaterialId() != model.getMaterialId() ||
+          nextTexture != texture) {
+        break;
+      }
+      runEnd++;
+    }
+
+    if (model.getMaterialId() != currentMaterial) {
+      currentMaterial = model.getMaterialId();
+      StateCache::bindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BINDING,
+                                  materialBuffer,
+                                  currentMaterial * materialStride,
+                                  sizeof(CoreMaterial));
+      stats.stateChanges++;
+      stats.materialChanges++;
+    }
+
+    if (texture != currentTexture) {
+      glUniform1i(texturedLocation, texture != 0);
+      if (texture != 0) {
+        StateCache::bindTexture(GL_TEXTURE_2D, texture);
+      }
+      currentTexture = texture;
+      stats.stateChanges++;
+    }
+
+    if (stats.multiDrawIndirect) {
+      glMultiDrawElementsIndirect(
+          GL_TRIANGLES, GL_UNSIGNED_INT,
+          reinterpret_cast<void*>(i * sizeof(DrawElementsIndirectCommand)),
+          static_cast<GLsizei>(runEnd - i), 0);
+      stats.indirectCommands += static_cast<uint32_t>(runEnd - i);
+    } else {
+      if (packet.transform != currentTransform) {
+        setTransform(queue.getTransform(packet.transform));
+        currentTransform = packet.transform;
+      }
+      model.draw();
+    }
+    for (size_t j = i; j < runEnd; j++) {
+      stats.triangles += packets[j].model->getIndexCount() / 3;
+      stats.vertices += packets[j].model->getVertexCount();
+    }
+    stats.drawCalls++;
+    i = runEnd;
+  }
+
+  if (stats.multiDrawIndirect) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  stats.bufferBinds = StateCache::getBufferBinds() - bufferBinds;
+  stats.textureBinds = StateCache::getTextureBinds() - textureBinds;
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+
+  auto end = std::chrono::steady_clock::now();
+  stats.submitMilliseconds =
+      std::chrono::duration<double, std::milli>(end - start).count();
+}
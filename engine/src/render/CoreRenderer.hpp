@@ -0,0 +1,90 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "LightClusters.hpp"
+#include "RenderQueue.hpp"
+#include "RenderStats.hpp"
+
+class Light;
+
+struct CoreMaterial {
+  glm::vec4 ambient;
+  glm::vec4 diffuse;
+  glm::vec4 specular;
+  glm::vec4 emission;
+  float shininess;
+  float padding[3];
+};
+
+struct CoreLight {
+  glm::vec4 position;   // w = 0 for directional lights
+  glm::vec4 direction;  // w = cosine of the spot cutoff
+  glm::vec4 color;      // w = range, 0 if unbounded
+};
+
+// Per-draw transform, read by the mesh shader as an instanced attribute
+struct InstanceTransform {
+  glm::mat4 modelView;
+  glm::vec3 normalMatrix[3];
+};
+
+struct TextureBuffer {
+  GLuint buffer = 0;
+  GLuint texture = 0;
+};
+
+class CoreRenderer {
+ private:
+  GLuint program = 0;
+  GLint litLocation = -1;
+  GLint texturedLocation = -1;
+  GLint globalLightCountLocation = -1;
+  GLint viewportSizeLocation = -1;
+  GLint clusterDepthLocation = -1;
+
+  GLuint vertexArray = 0;
+  GLuint vertexArrayVertices = 0;
+  GLuint vertexArrayIndices = 0;
+
+  GLuint transformBuffer = 0;
+  std::vector<InstanceTransform> instanceTransforms;
+
+  GLuint cameraBuffer = 0;
+  GLuint materialBuffer = 0;
+  GLint materialStride = 0;
+  size_t uploadedMaterials = 0;
+
+  LightClusters clusters;
+  std::vector<CoreLight> lightData;
+  std::vector<ClusterLight> clusterLights;
+  uint32_t globalLightCount = 0;
+  double binningMilliseconds = 0.0;
+  TextureBuffer lightBuffer;
+  TextureBuffer clusterBuffer;
+  TextureBuffer indexBuffer;
+  glm::vec2 viewportSize = glm::vec2(1.0f);
+
+  RenderStats stats;
+
+  void bindGeometry();
+  void uploadMaterials();
+  void uploadLights();
+  void uploadTransforms(const RenderQueue& queue);
+  void setTransform(const glm::mat4& modelView);
+
+ public:
+  bool initialize(const std::string& vertexPath,
+                  const std::string& fragmentPath);
+  void reset();
+  void setCamera(const glm::mat4& view, const glm::mat4& projection,
+                 const glm::vec2& viewportSize);
+  void setLights(std::vector<Light>& lights, const glm::mat4& view);
+  void submit(RenderQueue& queue, bool useMultiDraw);
+  const RenderStats& getStats() const { return stats; }
+};
@@ -0,0 +1,266 @@
+#include "DebugDraw.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Shader.hpp"
+#include "StateCache.hpp"
+
+static constexpr size_t INITIAL_STREAM_CAPACITY = 1024;
+
+std::vector<DebugVertex> DebugDraw::streamVertices;
+GLuint DebugDraw::streamBuffer = 0;
+size_t DebugDraw::streamCapacity = 0;
+std::vector<DebugLines> DebugDraw::cachedLines;
+std::vector<DebugLinesDraw> DebugDraw::cachedDraws;
+GLuint DebugDraw::program = 0;
+GLuint DebugDraw::vertexArray = 0;
+GLint DebugDraw::modelViewProjectionLocation = -1;
+bool DebugDraw::programFailed = false;
+bool DebugDraw::enabled = true;
+
+/**
+ * @brief Queues a world space line for the current frame.
+ *
+ * @param start The start of the line.
+ * @param end The end of the line.
+ * @param color The color of the line.
+ */
+void DebugDraw::line(const glm::vec3& start, const glm::vec3& end,
+                     const glm::vec3& color) {
+  streamVertices.push_back({start, color});
+  streamVertices.push_back({end, color});
+}
+
+/**
+ * @brief Uploads line geometry that is drawn over several frames.
+ *
+ * @param vertices The vertices of the lines, in object space.
+ * @param mode The primitive used to draw them, GL_LINES or GL_LINE_LOOP.
+ * @return The handle of the cached lines.
+ */
+uint32_t DebugDraw::createLines(const std::vector<glm::vec3>& vertices,
+                                GLenum mode) {
+  DebugLines lines = {0, mode, 0};
+  glGenBuffers(1, &lines.buffer);
+  cachedLines.push_back(lines);
+
+  uint32_t handle = static_cast<uint32_t>(cachedLines.size() - 1);
+  updateLines(handle, vertices);
+  return handle;
+}
+
+/**
+ * @brief Replaces the geometry of cached lines once their inputs changed.
+ *
+ * @param lines The handle of the cached lines.
+ * @param vertices The new vertices of the lines.
+ */
+void DebugDraw::updateLines(uint32_t lines,
+                            const std::vector<glm::vec3>& vertices) {
+  DebugLines& cached = cachedLines[lines];
+  cached.vertexCount = static_cast<uint32_t>(vertices.size());
+
+  StateCache::bindBuffer(GL_ARRAY_BUFFER, cached.buffer);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3),
+               vertices.data(), GL_STATIC_DRAW);
+}
+
+/**
+ * @brief Queues a draw of cached lines for the current frame.
+ *
+ * @param lines The handle of the cached lines.
+ * @param modelView The model view matrix of the lines.
+ * @param color The color of the lines.
+ */
+void DebugDraw::drawLines(uint32_t lines, const glm::mat4& modelView,
+                          const glm::vec3& color) {
+  cachedDraws.push_back({lines, modelView, color});
+}
+
+/**
+ * @brief Uploads the lines queued this frame to the streaming buffer.
+ *
+ * The buffer is allocated once and only grows, its storage is orphaned every
+ * frame so the upload never waits on the previous frame's draws.
+ */
+void DebugDraw::uploadStream() {
+  if (streamBuffer == 0) {
+    glGenBuffers(1, &streamBuffer);
+  }
+  StateCache::bindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+
+  size_t capacity = std::max(streamCapacity, INITIAL_STREAM_CAPACITY);
+  while (capacity < streamVertices.size()) {
+    capacity *= 2;
+  }
+  streamCapacity = capacity;
+
+  glBufferData(GL_ARRAY_BUFFER, streamCapacity * sizeof(DebugVertex), nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0,
+                  streamVertices.size() * sizeof(DebugVertex),
+                  streamVertices.data());
+}
+
+/**
+ * @brief Draws the queued lines with the fixed-function pipeline.
+ *
+ * @param view The view matrix of the world space lines.
+ */
+void DebugDraw::flushLegacy(const glm::mat4& view) {
+  bool lighting = StateCache::isEnabled(GL_LIGHTING);
+  StateCache::disable(GL_LIGHTING);
+  StateCache::disable(GL_TEXTURE_2D);
+
+  StateCache::enableClientState(GL_VERTEX_ARRAY);
+  StateCache::disableClientState(GL_NORMAL_ARRAY);
+  StateCache::disableClientState(GL_TEXTURE_COORD_ARRAY);
+
+  if (!streamVertices.empty()) {
+    uploadStream();
+    StateCache::enableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(DebugVertex),
+                    reinterpret_cast<void*>(offsetof(DebugVertex, position)));
+    glColorPointer(3, GL_FLOAT, sizeof(DebugVertex),
+                   reinterpret_cast<void*>(offsetof(DebugVertex, color)));
+    StateCache::loadModelView(view);
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(streamVertices.size()));
+  }
+
+  StateCache::disableClientState(GL_COLOR_ARRAY);
+
+  for (const DebugLinesDraw& draw : cachedDraws) {
+    const DebugLines& lines = cachedLines[draw.lines];
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, lines.buffer);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    glColor3f(draw.color.r, draw.color.g, draw.color.b);
+    StateCache::loadModelView(draw.modelView);
+    glDrawArrays(lines.mode, 0, lines.vertexCount);
+  }
+
+  // Reset color
+  glColor3f(1.0f, 1.0f, 1.0f);
+
+  StateCache::loadModelView(view);
+  if (lighting) {
+    StateCache::enable(GL_LIGHTING);
+  }
+}
+
+/**
+ * @brief Draws the queued lines with the core profile line program.
+ *
+ * @param view The view matrix of the world space lines.
+ * @param projection The projection matrix.
+ */
+void DebugDraw::flushCore(const glm::mat4& view, const glm::mat4& projection) {
+  if (program == 0) {
+    if (programFailed) {
+      return;
+    }
+    program = loadProgram("engine/assets/shaders/debug.vert",
+                          "engine/assets/shaders/debug.frag");
+    if (program == 0) {
+      programFailed = true;
+      return;
+    }
+    modelViewProjectionLocation =
+        glGetUniformLocation(program, "modelViewProjection");
+
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    glEnableVertexAttribArray(0);
+  }
+
+  glUseProgram(program);
+  glBindVertexArray(vertexArray);
+
+  if (!streamVertices.empty()) {
+    uploadStream();
+    glVertexAttribPointer(
+        0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex),
+        reinterpret_cast<void*>(offsetof(DebugVertex, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(
+        1, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex),
+        reinterpret_cast<void*>(offsetof(DebugVertex, color)));
+    glm::mat4 viewProjection = projection * view;
+    glUniformMatrix4fv(modelViewProjectionLocation, 1, GL_FALSE,
+                       glm::value_ptr(viewProjection));
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(streamVertices.size()));
+  }
+
+  // Cached lines only have positions, their color is a constant attribute
+  glDisableVertexAttribArray(1);
+
+  for (const DebugLinesDraw& draw : cachedDraws) {
+    const DebugLines& lines = cachedLines[draw.lines];
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, lines.buffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glVertexAttrib3f(1, draw.color.r, draw.color.g, draw.color.b);
+    glm::mat4 modelViewProjection = projection * draw.modelView;
+    glUniformMatrix4fv(modelViewProjectionLocation, 1, GL_FALSE,
+                       glm::value_ptr(modelViewProjection));
+    glDrawArrays(lines.mode, 0, lines.vertexCount);
+  }
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+}
+
+/**
+ * @brief Draws every line queued this frame and clears the queues.
+ *
+ * All the streamed lines are drawn with a single call, cached lines with one
+ * call each, so turning on debug geometry no longer costs a draw per vertex.
+ *
+ * @param view The view matrix of the world space lines.
+ * @param projection The projection matrix, used by the core profile only.
+ * @param core Whether the core profile renderer is active.
+ */
+void DebugDraw::flush(const glm::mat4& view, const glm::mat4& projection,
+                      bool core) {
+  if (!streamVertices.empty() || !cachedDraws.empty()) {
+    if (core) {
+      flushCore(view, projection);
+    } else {
+      flushLegacy(view);
+    }
+  }
+
+  streamVertices.clear();
+  cachedDraws.clear();
+}
+
+/**
+ * @brief Forgets the streaming buffer, the cached lines and the line program.
+ *
+ * This does not delete them, it must be called once the GL context owning
+ * them has been destroyed. Handles held by the old scene become invalid.
+ */
+void DebugDraw::reset() {
+  streamVertices.clear();
+  streamBuffer = 0;
+  streamCapacity = 0;
+  cachedLines.clear();
+  cachedDraws.clear();
+  program = 0;
+  vertexArray = 0;
+  modelViewProjectionLocation = -1;
+  programFailed = false;
+}
+
+/**
+ * @brief Returns the size of the buffer of cached lines.
+ *
+ * @param lines The handle returned by createLines, or INVALID_LINES.
+ * @return The size of the buffer in bytes, 0 for an invalid handle.
+ */
+size_t DebugDraw::getLinesSize(uint32_t lines) {
+  if (lines == INVALID_LINES || lines >= cachedLines.size()) {
+    return 0;
+  }
+  return cachedLines[lines].vertexCount * sizeof(glm::vec3);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct DebugVertex {
+  glm::vec3 position;
+  glm::vec3 color;
+};
+
+struct DebugLines {
+  GLuint buffer;
+  GLenum mode;
+  uint32_t vertexCount;
+};
+
+struct DebugLinesDraw {
+  uint32_t lines;
+  glm::mat4 modelView;
+  glm::vec3 color;
+};
+
+class DebugDraw {
+  static std::vector<DebugVertex> streamVertices;
+  static GLuint streamBuffer;
+  static size_t streamCapacity;
+  static std::vector<DebugLines> cachedLines;
+  static std::vector<DebugLinesDraw> cachedDraws;
+  static GLuint program;
+  static GLuint vertexArray;
+  static GLint modelViewProjectionLocation;
+  static bool programFailed;
+  static bool enabled;
+
+  static void uploadStream();
+  static void flushLegacy(const glm::mat4& view);
+  static void flushCore(const glm::mat4& view, const glm::mat4& projection);
+
+ public:
+  static constexpr uint32_t INVALID_LINES = UINT32_MAX;
+
+  static void line(const glm::vec3& start, const glm::vec3& end,
+                   const glm::vec3& color);
+  static uint32_t createLines(const std::vector<glm::vec3>& vertices,
+                              GLenum mode);
+  static void updateLines(uint32_t lines,
+                          const std::vector<glm::vec3>& vertices);
+  static void drawLines(uint32_t lines, const glm::mat4& modelView,
+                        const glm::vec3& color);
+  static void flush(const glm::mat4& view, const glm::mat4& projection,
+                    bool core);
+  static void reset();
+  static size_t getLinesSize(uint32_t lines);
+  static void setEnabled(bool enabled) { DebugDraw::enabled = enabled; }
+  static bool isEnabled() { return enabled; }
+};
@@ -0,0 +1,48 @@
+#include "Frustum.hpp"
+
+/**
+ * @brief Extracts the clipping planes of a projection matrix.
+ *
+ * The planes are expressed in the space the matrix maps from, so the
+ * projection matrix alone gives view-space planes, and a view-projection
+ * matrix gives world-space planes.
+ *
+ * @param matrix The projection matrix.
+ */
+Frustum::Frustum(const glm::mat4& matrix) {
+  glm::vec4 x = glm::vec4(matrix[0][0], matrix[1][0], matrix[2][0],
+                          matrix[3][0]);
+  glm::vec4 y = glm::vec4(matrix[0][1], matrix[1][1], matrix[2][1],
+                          matrix[3][1]);
+  glm::vec4 z = glm::vec4(matrix[0][2], matrix[1][2], matrix[2][2],
+                          matrix[3][2]);
+  glm::vec4 w = glm::vec4(matrix[0][3], matrix[1][3], matrix[2][3],
+                          matrix[3][3]);
+
+  planes[0] = w + x;  // Left
+  planes[1] = w - x;  // Right
+  planes[2] = w + y;  // Bottom
+  planes[3] = w - y;  // Top
+  planes[4] = w + z;  // Near
+  planes[5] = w - z;  // Far
+
+  for (glm::vec4& plane : planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+}
+
+/**
+ * @brief Checks whether a bounding sphere is at least partially inside.
+ *
+ * @param center The center of the sphere.
+ * @param radius The radius of the sphere.
+ * @return false if the sphere is fully outside one of the planes.
+ */
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+  for (const glm::vec4& plane : planes) {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
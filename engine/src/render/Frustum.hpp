@@ -0,0 +1,13 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+class Frustum {
+ private:
+  glm::vec4 planes[6];
+
+ public:
+  Frustum() : Frustum(glm::mat4(1.0f)) {}
+  explicit Frustum(const glm::mat4& matrix);
+  bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
@@ -0,0 +1,402 @@
+#include "GeometryHeap.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "StateCache.hpp"
+#include "debug/Logger.hpp"
+
+static debug::Logger logger;
+
+static constexpr uint32_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+static constexpr uint32_t INITIAL_INDEX_CAPACITY = 1 << 18;
+static constexpr float DEFRAGMENT_THRESHOLD = 0.5f;
+
+GLuint GeometryHeap::vertexBuffer = 0;
+GLuint GeometryHeap::indexBuffer = 0;
+RangeAllocator GeometryHeap::vertexAllocator;
+RangeAllocator GeometryHeap::indexAllocator;
+std::vector<GeometryAllocation> GeometryHeap::allocations;
+std::vector<uint32_t> GeometryHeap::freeHandles;
+uint32_t GeometryHeap::defragmentations = 0;
+
+void RangeAllocator::reset(uint32_t capacity) {
+  this->capacity = capacity;
+  freeRanges.clear();
+  if (capacity > 0) {
+    freeRanges.push_back({0, capacity});
+  }
+}
+
+/**
+ * @brief Extends the allocator with free space at its end.
+ *
+ * @param capacity The new capacity, larger than the current one.
+ */
+void RangeAllocator::grow(uint32_t capacity) {
+  uint32_t added = capacity - this->capacity;
+  if (!freeRanges.empty() &&
+      freeRanges.back().offset + freeRanges.back().size == this->capacity) {
+    freeRanges.back().size += added;
+  } else {
+    freeRanges.push_back({this->capacity, added});
+  }
+  this->capacity = capacity;
+}
+
+/**
+ * @brief Allocates a range using a first-fit search of the free list.
+ *
+ * @param size The size of the range.
+ * @param offset Receives the offset of the range.
+ * @return true if a large enough free range was found.
+ */
+bool RangeAllocator::allocate(uint32_t size, uint32_t& offset) {
+  for (size_t i = 0; i < freeRanges.size(); i++) {
+    HeapRange& range = freeRanges[i];
+    if (range.size < size) {
+      continue;
+    }
+
+    offset = range.offset;
+    range.offset += size;
+    range.size -= size;
+    if (range.size == 0) {
+      freeRanges.erase(freeRanges.begin() + i);
+    }
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Returns a range to the free list, merging it with its neighbours.
+ *
+ * @param offset The offset of the range.
+ * @param size The size of the range.
+ */
+void RangeAllocator::free(uint32_t offset, uint32_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  auto next = std::lower_bound(
+      freeRanges.begin(), freeRanges.end(), offset,
+      [](const HeapRange& range, uint32_t value) {
+        return range.offset < value;
+      });
+  auto it = freeRanges.insert(next, {offset, size});
+
+  if (it + 1 != freeRanges.end() &&
+      it->offset + it->size == (it + 1)->offset) {
+    it->size += (it + 1)->size;
+    freeRanges.erase(it + 1);
+  }
+
+  if (it != freeRanges.begin() &&
+      (it - 1)->offset + (it - 1)->size == it->offset) {
+    (it - 1)->size += it->size;
+    freeRanges.erase(it);
+  }
+}
+
+uint32_t RangeAllocator::getFreeSize() const {
+  uint32_t size = 0;
+  for (const HeapRange& range : freeRanges) {
+    size += range.size;
+  }
+  return size;
+}
+
+uint32_t RangeAllocator::getLargestFreeRange() const {
+  uint32_t size = 0;
+  for (const HeapRange& range : freeRanges) {
+    size = std::max(size, range.size);
+  }
+  return size;
+}
+
+/**
+ * @brief Creates a buffer object of a given size without initial data.
+ *
+ * The buffer is bound to GL_COPY_WRITE_BUFFER, which is not tracked by the
+ * StateCache, so the vertex and index bindings are left untouched.
+ */
+static GLuint createBuffer(size_t bytes) {
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+  return buffer;
+}
+
+static void copyBuffer(GLuint source, GLuint destination, size_t sourceOffset,
+                       size_t destinationOffset, size_t bytes) {
+  glBindBuffer(GL_COPY_READ_BUFFER, source);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset,
+                      destinationOffset, bytes);
+}
+
+void GeometryHeap::initialize() {
+  if (!GLEW_VERSION_3_2 && !GLEW_ARB_draw_elements_base_vertex) {
+    logger.error(
+        "glDrawElementsBaseVertex is not supported, geometry will not draw.");
+  }
+
+  vertexBuffer = createBuffer(INITIAL_VERTEX_CAPACITY * sizeof(HeapVertex));
+  indexBuffer = createBuffer(INITIAL_INDEX_CAPACITY * sizeof(uint32_t));
+  vertexAllocator.reset(INITIAL_VERTEX_CAPACITY);
+  indexAllocator.reset(INITIAL_INDEX_CAPACITY);
+}
+
+/**
+ * @brief Reallocates the arenas with a larger capacity, keeping their data.
+ *
+ * @param vertexCapacity The new vertex capacity.
+ * @param indexCapacity The new index capacity.
+ */
+void GeometryHeap::grow(uint32_t vertexCapacity, uint32_t indexCapacity) {
+  if (vertexCapacity > vertexAllocator.getCapacity()) {
+    GLuint buffer = createBuffer(vertexCapacity * sizeof(HeapVertex));
+    copyBuffer(vertexBuffer, buffer, 0, 0,
+               vertexAllocator.getCapacity() * sizeof(HeapVertex));
+    glDeleteBuffers(1, &vertexBuffer);
+    vertexBuffer = buffer;
+    vertexAllocator.grow(vertexCapacity);
+  }
+
+  if (indexCapacity > indexAllocator.getCapacity()) {
+    GLuint buffer = createBuffer(indexCapacity * sizeof(uint32_t));
+    copyBuffer(indexBuffer, buffer, 0, 0,
+               indexAllocator.getCapacity() * sizeof(uint32_t));
+    glDeleteBuffers(1, &indexBuffer);
+    indexBuffer = buffer;
+    indexAllocator.grow(indexCapacity);
+  }
+
+  // Deleting a bound buffer resets its binding behind the cache
+  StateCache::invalidate();
+}
+
+/**
+ * @brief Uploads a mesh into the shared vertex and index arenas.
+ *
+ * Indices are relative to the first vertex of the mesh and are rebased at
+ * draw time, so meshes can be moved around by defragment without touching
+ * their indices. The arenas grow when no free range is large enough.
+ *
+ * @param vertices The interleaved vertices of the mesh.
+ * @param indices The triangle indices of the mesh.
+ * @return A handle to the allocation.
+ */
+uint32_t GeometryHeap::upload(const std::vector<HeapVertex>& vertices,
+                              const std::vector<uint32_t>& indices) {
+  if (vertexBuffer == 0) {
+    initialize();
+  }
+
+  uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+  uint32_t indexCount = static_cast<uint32_t>(indices.size());
+
+  GeometryAllocation allocation = {0, vertexCount, 0, indexCount, true};
+
+  if (!vertexAllocator.allocate(vertexCount, allocation.vertexOffset)) {
+    uint32_t capacity = vertexAllocator.getCapacity();
+    grow(std::max(capacity * 2, capacity + vertexCount),
+         indexAllocator.getCapacity());
+    vertexAllocator.allocate(vertexCount, allocation.vertexOffset);
+  }
+
+  if (!indexAllocator.allocate(indexCount, allocation.indexOffset)) {
+    uint32_t capacity = indexAllocator.getCapacity();
+    grow(vertexAllocator.getCapacity(),
+         std::max(capacity * 2, capacity + indexCount));
+    indexAllocator.allocate(indexCount, allocation.indexOffset);
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+  glBufferSubData(GL_COPY_WRITE_BUFFER,
+                  allocation.vertexOffset * sizeof(HeapVertex),
+                  vertexCount * sizeof(HeapVertex), vertices.data());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+  glBufferSubData(GL_COPY_WRITE_BUFFER,
+                  allocation.indexOffset * sizeof(uint32_t),
+                  indexCount * sizeof(uint32_t), indices.data());
+
+  if (!freeHandles.empty()) {
+    uint32_t handle = freeHandles.back();
+    freeHandles.pop_back();
+    allocations[handle] = allocation;
+    return handle;
+  }
+
+  allocations.push_back(allocation);
+  return static_cast<uint32_t>(allocations.size() - 1);
+}
+
+/**
+ * @brief Frees the ranges of a mesh.
+ *
+ * This only updates the free lists and never touches the GPU, so a whole
+ * scene can be released in a row, even after its context is gone. After a
+ * partial unload, call defragmentIfNeeded once to reclaim the holes.
+ *
+ * @param handle The handle returned by upload.
+ */
+void GeometryHeap::release(uint32_t handle) {
+  if (handle >= allocations.size() || !allocations[handle].live) {
+    return;
+  }
+
+  GeometryAllocation& allocation = allocations[handle];
+  vertexAllocator.free(allocation.vertexOffset, allocation.vertexCount);
+  indexAllocator.free(allocation.indexOffset, allocation.indexCount);
+  allocation.live = false;
+  freeHandles.push_back(handle);
+}
+
+/**
+ * @brief Compacts the arenas if too much of their free space is split in
+ * ranges too small to be reused.
+ *
+ * @return true if the arenas were compacted.
+ */
+bool GeometryHeap::defragmentIfNeeded() {
+  if (getFragmentation() <= DEFRAGMENT_THRESHOLD) {
+    return false;
+  }
+  defragment();
+  return true;
+}
+
+/**
+ * @brief Compacts all live meshes to the start of the arenas.
+ *
+ * Meshes are copied on the GPU into new buffers in their current order, and
+ * their handles are updated in place, so models keep drawing the same data.
+ */
+void GeometryHeap::defragment() {
+  if (vertexBuffer == 0) {
+    return;
+  }
+
+  std::vector<uint32_t> live;
+  for (uint32_t handle = 0; handle < allocations.size(); handle++) {
+    if (allocations[handle].live) {
+      live.push_back(handle);
+    }
+  }
+
+  GLuint vertices =
+      createBuffer(vertexAllocator.getCapacity() * sizeof(HeapVertex));
+  std::sort(live.begin(), live.end(), [](uint32_t a, uint32_t b) {
+    return allocations[a].vertexOffset < allocations[b].vertexOffset;
+  });
+  uint32_t vertexCursor = 0;
+  for (uint32_t handle : live) {
+    GeometryAllocation& allocation = allocations[handle];
+    copyBuffer(vertexBuffer, vertices,
+               allocation.vertexOffset * sizeof(HeapVertex),
+               vertexCursor * sizeof(HeapVertex),
+               allocation.vertexCount * sizeof(HeapVertex));
+    allocation.vertexOffset = vertexCursor;
+    vertexCursor += allocation.vertexCount;
+  }
+
+  GLuint indices =
+      createBuffer(indexAllocator.getCapacity() * sizeof(uint32_t));
+  std::sort(live.begin(), live.end(), [](uint32_t a, uint32_t b) {
+    return allocations[a].indexOffset < allocations[b].indexOffset;
+  });
+  uint32_t indexCursor = 0;
+  for (uint32_t handle : live) {
+    GeometryAllocation& allocation = allocations[handle];
+    copyBuffer(indexBuffer, indices, allocation.indexOffset * sizeof(uint32_t),
+               indexCursor * sizeof(uint32_t),
+               allocation.indexCount * sizeof(uint32_t));
+    allocation.indexOffset = indexCursor;
+    indexCursor += allocation.indexCount;
+  }
+
+  glDeleteBuffers(1, &vertexBuffer);
+  glDeleteBuffers(1, &indexBuffer);
+  vertexBuffer = vertices;
+  indexBuffer = indices;
+
+  uint32_t vertexCapacity = vertexAllocator.getCapacity();
+  uint32_t indexCapacity = indexAllocator.getCapacity();
+  uint32_t offset;
+  vertexAllocator.reset(vertexCapacity);
+  vertexAllocator.allocate(vertexCursor, offset);
+  indexAllocator.reset(indexCapacity);
+  indexAllocator.allocate(indexCursor, offset);
+
+  StateCache::invalidate();
+  defragmentations++;
+}
+
+/**
+ * @brief Forgets all meshes and buffers.
+ *
+ * This does not delete the buffers, it must be called once the GL context
+ * owning them has been destroyed.
+ */
+void GeometryHeap::reset() {
+  vertexBuffer = 0;
+  indexBuffer = 0;
+  vertexAllocator.reset(0);
+  indexAllocator.reset(0);
+  allocations.clear();
+  freeHandles.clear();
+}
+
+/**
+ * @brief Binds the arenas and points the client arrays at them.
+ *
+ * Every mesh shares the same interleaved layout, so this is done once per
+ * frame instead of once per draw.
+ */
+void GeometryHeap::bind() {
+  StateCache::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+  StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+  glVertexPointer(3, GL_FLOAT, sizeof(HeapVertex),
+                  reinterpret_cast<void*>(offsetof(HeapVertex, position)));
+  glNormalPointer(GL_FLOAT, sizeof(HeapVertex),
+                  reinterpret_cast<void*>(offsetof(HeapVertex, normal)));
+  glTexCoordPointer(2, GL_FLOAT, sizeof(HeapVertex),
+                    reinterpret_cast<void*>(offsetof(HeapVertex, texCoord)));
+}
+
+/**
+ * @brief Draws a mesh from the bound arenas.
+ *
+ * @param handle The handle returned by upload.
+ */
+void GeometryHeap::draw(uint32_t handle) {
+  const GeometryAllocation& allocation = allocations[handle];
+  glDrawElementsBaseVertex(
+      GL_TRIANGLES, allocation.indexCount, GL_UNSIGNED_INT,
+      reinterpret_cast<void*>(allocation.indexOffset * sizeof(uint32_t)),
+      allocation.vertexOffset);
+}
+
+/**
+ * @brief Returns how fragmented the free space of the arenas is.
+ *
+ * @return 0 when the free space of both arenas is contiguous, approaching 1
+ * as it gets split into many small ranges.
+ */
+float GeometryHeap::getFragmentation() {
+  float fragmentation = 0.0f;
+  for (const RangeAllocator* allocator : {&vertexAllocator, &indexAllocator}) {
+    uint32_t free = allocator->getFreeSize();
+    if (free > 0) {
+      fragmentation = std::max(
+          fragmentation,
+          1.0f - static_cast<float>(allocator->getLargestFreeRange()) / free);
+    }
+  }
+  return fragmentation;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct HeapVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 texCoord;
+};
+
+struct HeapRange {
+  uint32_t offset;
+  uint32_t size;
+};
+
+class RangeAllocator {
+ private:
+  uint32_t capacity = 0;
+  std::vector<HeapRange> freeRanges;
+
+ public:
+  void reset(uint32_t capacity);
+  void grow(uint32_t capacity);
+  bool allocate(uint32_t size, uint32_t& offset);
+  void free(uint32_t offset, uint32_t size);
+  uint32_t getCapacity() const { return capacity; }
+  uint32_t getFreeSize() const;
+  uint32_t getLargestFreeRange() const;
+  const std::vector<HeapRange>& getFreeRanges() const { return freeRanges; }
+};
+
+struct GeometryAllocation {
+  uint32_t vertexOffset;
+  uint32_t vertexCount;
+  uint32_t indexOffset;
+  uint32_t indexCount;
+  bool live;
+};
+
+class GeometryHeap {
+  static GLuint vertexBuffer;
+  static GLuint indexBuffer;
+  static RangeAllocator vertexAllocator;
+  static RangeAllocator indexAllocator;
+  static std::vector<GeometryAllocation> allocations;
+  static std::vector<uint32_t> freeHandles;
+  static uint32_t defragmentations;
+
+  static void initialize();
+  static void grow(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+ public:
+  static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+  static uint32_t upload(const std::vector<HeapVertex>& vertices,
+                         const std::vector<uint32_t>& indices);
+  static void release(uint32_t handle);
+  static void defragment();
+  static bool defragmentIfNeeded();
+  static void reset();
+  static void bind();
+  static void draw(uint32_t handle);
+
+  static const GeometryAllocation& get(uint32_t handle) {
+    return allocations[handle];
+  }
+  static const RangeAllocator& getVertexAllocator() { return vertexAllocator; }
+  static const RangeAllocator& getIndexAllocator() { return indexAllocator; }
+  static size_t getLiveAllocationCount() {
+    return allocations.size() - freeHandles.size();
+  }
+  static uint32_t getDefragmentationCount() { return defragmentations; }
+  static float getFragmentation();
+  static GLuint getVertexBuffer() { return vertexBuffer; }
+  static GLuint getIndexBuffer() { return indexBuffer; }
+};
@@ -0,0 +1,130 @@
+#include "GpuTimer.hpp"
+
+#include "debug/Logger.hpp"
+
+static debug::Logger logger;
+
+static const char* PHASE_NAMES[GPU_PHASE_COUNT] = {"Lights", "Scene",
+                                                   "Debug", "UI"};
+
+/**
+ * @brief Creates the timestamp queries of every frame in flight.
+ *
+ * Timestamps are used instead of GL_TIME_ELAPSED ranges since those cannot
+ * overlap, and one timestamp between two phases ends one and starts the
+ * other.
+ */
+void GpuTimer::initialize() {
+  initialized = true;
+  supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+  if (!supported) {
+    logger.info("Timer queries are not supported, GPU timings are disabled.");
+    return;
+  }
+
+  for (int i = 0; i < LATENCY; i++) {
+    glGenQueries(GPU_PHASE_COUNT + 1, queries[i]);
+  }
+}
+
+/**
+ * @brief Reads the timestamps of a frame in flight if they are ready.
+ *
+ * A frame whose results are not ready yet is dropped rather than waited for.
+ *
+ * @param slot The slot of the frame.
+ */
+void GpuTimer::collect(int slot) {
+  if (!pending[slot]) {
+    return;
+  }
+  pending[slot] = false;
+
+  GLint available = 0;
+  glGetQueryObjectiv(queries[slot][GPU_PHASE_COUNT], GL_QUERY_RESULT_AVAILABLE,
+                     &available);
+  if (!available) {
+    return;
+  }
+
+  GLuint64 timestamps[GPU_PHASE_COUNT + 1];
+  for (int i = 0; i <= GPU_PHASE_COUNT; i++) {
+    glGetQueryObjectui64v(queries[slot][i], GL_QUERY_RESULT, &timestamps[i]);
+  }
+
+  for (int i = 0; i < GPU_PHASE_COUNT; i++) {
+    milliseconds[i] = (timestamps[i + 1] - timestamps[i]) / 1e6;
+  }
+  totalMilliseconds = (timestamps[GPU_PHASE_COUNT] - timestamps[0]) / 1e6;
+  results++;
+}
+
+/**
+ * @brief Starts timing a frame.
+ *
+ * Reads the results of the frame that last used this slot, LATENCY frames
+ * ago, and records the start timestamp.
+ */
+void GpuTimer::beginFrame() {
+  if (!initialized) {
+    initialize();
+  }
+  if (!supported) {
+    return;
+  }
+
+  collect(frame);
+  phase = 0;
+  glQueryCounter(queries[frame][0], GL_TIMESTAMP);
+}
+
+/**
+ * @brief Ends a phase of the frame.
+ *
+ * Phases must end in order. Skipped phases are ended anyway and take no
+ * time.
+ *
+ * @param phase The phase that ended.
+ */
+void GpuTimer::endPhase(GpuPhase phase) {
+  if (!supported) {
+    return;
+  }
+
+  for (; this->phase <= phase; this->phase++) {
+    glQueryCounter(queries[frame][this->phase + 1], GL_TIMESTAMP);
+  }
+}
+
+/**
+ * @brief Ends the remaining phases and moves on to the next slot.
+ */
+void GpuTimer::endFrame() {
+  if (!supported) {
+    return;
+  }
+
+  endPhase(static_cast<GpuPhase>(GPU_PHASE_COUNT - 1));
+  pending[frame] = true;
+  frame = (frame + 1) % LATENCY;
+}
+
+/**
+ * @brief Forgets the queries of a destroyed context.
+ */
+void GpuTimer::reset() {
+  for (int i = 0; i < LATENCY; i++) {
+    for (int j = 0; j <= GPU_PHASE_COUNT; j++) {
+      queries[i][j] = 0;
+    }
+    pending[i] = false;
+  }
+  frame = 0;
+  phase = 0;
+  initialized = false;
+  supported = false;
+}
+
+const char* GpuTimer::getPhaseName(GpuPhase phase) {
+  return PHASE_NAMES[phase];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+
+enum GpuPhase { GPU_LIGHTS, GPU_SCENE, GPU_DEBUG, GPU_UI, GPU_PHASE_COUNT };
+
+class GpuTimer {
+ public:
+  // Frames in flight before a result is read, so reads never stall
+  static constexpr int LATENCY = 3;
+
+ private:
+  GLuint queries[LATENCY][GPU_PHASE_COUNT + 1] = {};
+  bool pending[LATENCY] = {};
+  int frame = 0;
+  int phase = 0;
+  bool initialized = false;
+  bool supported = false;
+  double milliseconds[GPU_PHASE_COUNT] = {};
+  double totalMilliseconds = 0.0;
+  uint64_t results = 0;
+
+  void initialize();
+  void collect(int slot);
+
+ public:
+  void beginFrame();
+  void endPhase(GpuPhase phase);
+  void endFrame();
+  void reset();
+  bool isSupported() const { return supported; }
+  double getMilliseconds(GpuPhase phase) const { return milliseconds[phase]; }
+  double getTotalMilliseconds() const { return totalMilliseconds; }
+  uint64_t getResultCount() const { return results; }
+  static const char* getPhaseName(GpuPhase phase);
+};
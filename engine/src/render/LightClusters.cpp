@@ -0,0 +1,186 @@
+#include "LightClusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CLUSTERS_SSE2
+#endif
+
+/**
+ * @brief Updates the view frustum the grid is built over.
+ *
+ * The cluster bounds only depend on the projection, so they are recomputed
+ * when it changes instead of every frame.
+ *
+ * @param projection A symmetric perspective projection matrix.
+ */
+void LightClusters::setProjection(const glm::mat4& projection) {
+  if (projection == this->projection) {
+    return;
+  }
+
+  this->projection = projection;
+  tanX = 1.0f / projection[0][0];
+  tanY = 1.0f / projection[1][1];
+  near = projection[3][2] / (projection[2][2] - 1.0f);
+  far = projection[3][2] / (projection[2][2] + 1.0f);
+  computeBounds();
+}
+
+/**
+ * @brief Computes the view-space bounding box of every cluster.
+ *
+ * Tiles split the screen evenly, and depth slices grow exponentially from
+ * the near to the far plane, so clusters keep a similar shape with distance.
+ */
+void LightClusters::computeBounds() {
+  for (int z = 0; z < GRID_Z; z++) {
+    sliceNear[z] = near * std::pow(far / near, static_cast<float>(z) / GRID_Z);
+    sliceFar[z] =
+        near * std::pow(far / near, static_cast<float>(z + 1) / GRID_Z);
+
+    for (int y = 0; y < GRID_Y; y++) {
+      float bottom = -1.0f + 2.0f * y / GRID_Y;
+      float top = -1.0f + 2.0f * (y + 1) / GRID_Y;
+
+      for (int x = 0; x < GRID_X; x++) {
+        float left = -1.0f + 2.0f * x / GRID_X;
+        float right = -1.0f + 2.0f * (x + 1) / GRID_X;
+
+        // The tile edges spread out with depth, so take both slice planes
+        int cluster = (z * GRID_Y + y) * GRID_X + x;
+        minX[cluster] = std::min(left * tanX * sliceNear[z],
+                                 left * tanX * sliceFar[z]);
+        maxX[cluster] = std::max(right * tanX * sliceNear[z],
+                                 right * tanX * sliceFar[z]);
+        minY[cluster] = std::min(bottom * tanY * sliceNear[z],
+                                 bottom * tanY * sliceFar[z]);
+        maxY[cluster] = std::max(top * tanY * sliceNear[z],
+                                 top * tanY * sliceFar[z]);
+      }
+    }
+  }
+}
+
+int LightClusters::sliceOf(float depth) const {
+  if (depth <= near) {
+    return 0;
+  }
+  int slice = static_cast<int>(std::log(depth / near) / std::log(far / near) *
+                               GRID_Z);
+  return std::clamp(slice, 0, GRID_Z - 1);
+}
+
+/**
+ * @brief Records the clusters touched by a light sphere.
+ *
+ * The depth slices come from the sphere extent, then every tile of those
+ * slices is tested against the sphere, four clusters at a time with SSE2.
+ *
+ * @param light The index of the light.
+ * @param sphere The view-space bounding sphere of the light.
+ */
+void LightClusters::binLight(uint32_t light, const ClusterLight& sphere) {
+  float depth = -sphere.center.z;
+  if (depth + sphere.radius < near || depth - sphere.radius > far) {
+    return;
+  }
+
+  int firstSlice = sliceOf(depth - sphere.radius);
+  int lastSlice = sliceOf(depth + sphere.radius);
+  float radiusSquared = sphere.radius * sphere.radius;
+
+  for (int z = firstSlice; z <= lastSlice; z++) {
+    float dz = std::max({0.0f, sliceNear[z] - depth, depth - sliceFar[z]});
+    float sliceDistance = dz * dz;
+    if (sliceDistance > radiusSquared) {
+      continue;
+    }
+
+    int first = z * TILES_PER_SLICE;
+
+#ifdef CLUSTERS_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 cx = _mm_set1_ps(sphere.center.x);
+    const __m128 cy = _mm_set1_ps(sphere.center.y);
+    const __m128 limit = _mm_set1_ps(radiusSquared - sliceDistance);
+
+    for (int i = 0; i < TILES_PER_SLICE; i += 4) {
+      int cluster = first + i;
+      __m128 dx = _mm_max_ps(
+          zero, _mm_max_ps(_mm_sub_ps(_mm_load_ps(&minX[cluster]), cx),
+                           _mm_sub_ps(cx, _mm_load_ps(&maxX[cluster]))));
+      __m128 dy = _mm_max_ps(
+          zero, _mm_max_ps(_mm_sub_ps(_mm_load_ps(&minY[cluster]), cy),
+                           _mm_sub_ps(cy, _mm_load_ps(&maxY[cluster]))));
+      __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+      int mask = _mm_movemask_ps(_mm_cmple_ps(distance, limit));
+
+      while (mask != 0) {
+        int lane = 0;
+        while ((mask & (1 << lane)) == 0) {
+          lane++;
+        }
+        mask &= ~(1 << lane);
+        hits.push_back(static_cast<uint32_t>(cluster + lane));
+        hits.push_back(light);
+      }
+    }
+#else
+    for (int i = 0; i < TILES_PER_SLICE; i++) {
+      int cluster = first + i;
+      float dx = std::max({0.0f, minX[cluster] - sphere.center.x,
+                           sphere.center.x - maxX[cluster]});
+      float dy = std::max({0.0f, minY[cluster] - sphere.center.y,
+                           sphere.center.y - maxY[cluster]});
+      if (dx * dx + dy * dy <= radiusSquared - sliceDistance) {
+        hits.push_back(static_cast<uint32_t>(cluster));
+        hits.push_back(light);
+      }
+    }
+#endif
+  }
+}
+
+/**
+ * @brief Bins lights into the cluster grid and builds the light lists.
+ *
+ * Every (cluster, light) hit is recorded first, then a counting sort by
+ * cluster turns them into one contiguous index list per cluster.
+ *
+ * @param lights The view-space bounding spheres of the lights.
+ */
+void LightClusters::build(const std::vector<ClusterLight>& lights) {
+  hits.clear();
+  for (uint32_t light = 0; light < lights.size(); light++) {
+    binLight(light, lights[light]);
+  }
+
+  ranges.assign(CLUSTER_COUNT, {0, 0});
+  for (size_t i = 0; i < hits.size(); i += 2) {
+    ranges[hits[i]].count++;
+  }
+
+  uint32_t offset = 0;
+  for (ClusterRange& range : ranges) {
+    range.offset = offset;
+    offset += range.count;
+    range.count = 0;
+  }
+
+  indices.resize(offset);
+  for (size_t i = 0; i < hits.size(); i += 2) {
+    ClusterRange& range = ranges[hits[i]];
+    indices[range.offset + range.count++] = hits[i + 1];
+  }
+}
+
+uint32_t LightClusters::getMaxClusterLights() const {
+  uint32_t count = 0;
+  for (const ClusterRange& range : ranges) {
+    count = std::max(count, range.count);
+  }
+  return count;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct ClusterLight {
+  glm::vec3 center;
+  float radius;
+};
+
+struct ClusterRange {
+  uint32_t offset;
+  uint32_t count;
+};
+
+class LightClusters {
+ public:
+  static constexpr int GRID_X = 16;
+  static constexpr int GRID_Y = 9;
+  static constexpr int GRID_Z = 24;
+  static constexpr int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+  static constexpr int TILES_PER_SLICE = GRID_X * GRID_Y;
+
+ private:
+  glm::mat4 projection = glm::mat4(0.0f);
+  float tanX = 0.0f;
+  float tanY = 0.0f;
+  float near = 0.0f;
+  float far = 0.0f;
+
+  // Cluster bounds in view space, structure of arrays for SIMD tests
+  alignas(16) float minX[CLUSTER_COUNT];
+  alignas(16) float minY[CLUSTER_COUNT];
+  alignas(16) float maxX[CLUSTER_COUNT];
+  alignas(16) float maxY[CLUSTER_COUNT];
+  float sliceNear[GRID_Z];
+  float sliceFar[GRID_Z];
+
+  std::vector<uint32_t> hits;
+  std::vector<ClusterRange> ranges;
+  std::vector<uint32_t> indices;
+
+  void computeBounds();
+  int sliceOf(float depth) const;
+  void binLight(uint32_t light, const ClusterLight& sphere);
+
+ public:
+  void setProjection(const glm::mat4& projection);
+  void build(const std::vector<ClusterLight>& lights);
+
+  float getNear() const { return near; }
+  float getFar() const { return far; }
+  const std::vector<ClusterRange>& getRanges() const { return ranges; }
+  const std::vector<uint32_t>& getIndices() const { return indices; }
+  uint32_t getMaxClusterLights() const;
+};
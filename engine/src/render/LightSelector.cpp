@@ -0,0 +1,211 @@
+#include "LightSelector.hpp"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+#include "StateCache.hpp"
+#include "scene/Light.hpp"
+
+/**
+ * @brief Forgets the lights bound to every slot.
+ *
+ * This does not disable them, it must be called once the GL context owning
+ * them has been destroyed.
+ */
+void LightSelector::reset() {
+  candidates.clear();
+  for (int slot = 0; slot < MAX_LIGHTS; slot++) {
+    slots[slot] = -1;
+    dirty[slot] = false;
+  }
+}
+
+/**
+ * @brief Prepares the scene lights for this frame's selections.
+ *
+ * Light positions are stored in view space, like the draw bounds. Occupied
+ * slots are marked dirty, since their eye-space positions depend on the view
+ * matrix they were specified with.
+ *
+ * @param lights The lights of the scene.
+ * @param view The camera view matrix.
+ */
+void LightSelector::begin(std::vector<Light>& lights, const glm::mat4& view) {
+  if (lights.size() != candidates.size()) {
+    for (int slot = 0; slot < MAX_LIGHTS; slot++) {
+      slots[slot] = -1;
+      StateCache::disable(GL_LIGHT0 + slot);
+    }
+  }
+
+  candidates.clear();
+  for (Light& light : lights) {
+    Candidate candidate;
+    candidate.light = &light;
+    candidate.directional = light.getType() == DIRECTIONAL;
+    candidate.position = glm::vec3(view * glm::vec4(light.getPosition(), 1.0f));
+    candidate.direction = glm::mat3(view) * light.getDirection();
+    candidate.cutoff = light.getType() == SPOTLIGHT
+                           ? glm::radians(light.getCutoff())
+                           : glm::pi<float>();
+    candidate.cosCutoff = std::cos(candidate.cutoff);
+    candidate.range = light.getRange();
+
+    const glm::vec3& color = light.getColor();
+    candidate.intensity =
+        0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+
+    if (!candidate.directional && glm::length(candidate.direction) > 0.0f) {
+      candidate.direction = glm::normalize(candidate.direction);
+    }
+    candidates.push_back(candidate);
+  }
+
+  for (int slot = 0; slot < MAX_LIGHTS; slot++) {
+    dirty[slot] = slots[slot] >= 0;
+  }
+  rebinds = 0;
+  maxActiveLights = 0;
+}
+
+/**
+ * @brief Estimates how much a light contributes to a bounding sphere.
+ *
+ * Directional lights and lights without a range do not fade with distance,
+ * so only their intensity counts. Ranged lights fade out at their range, and
+ * spot lights are rejected when the sphere is fully outside their cone.
+ *
+ * @param candidate The light.
+ * @param center The view-space center of the sphere.
+ * @param radius The radius of the sphere.
+ * @param distance Receives the distance from the light to the sphere.
+ * @return The score of the light, 0 if it cannot reach the sphere.
+ */
+float LightSelector::score(const Candidate& candidate, const glm::vec3& center,
+                           float radius, float& distance) const {
+  if (candidate.directional) {
+    distance = 0.0f;
+    return candidate.intensity;
+  }
+
+  glm::vec3 toSphere = center - candidate.position;
+  float centerDistance = glm::length(toSphere);
+  distance = std::max(centerDistance - radius, 0.0f);
+
+  float attenuation = 1.0f;
+  if (candidate.range > 0.0f) {
+    if (distance >= candidate.range) {
+      return 0.0f;
+    }
+    float ratio = distance / candidate.range;
+    float window = 1.0f - ratio * ratio * ratio * ratio;
+    attenuation = window * window;
+  }
+
+  if (candidate.cutoff < glm::pi<float>() && centerDistance > radius) {
+    float angle = std::acos(std::clamp(
+        glm::dot(candidate.direction, toSphere / centerDistance), -1.0f,
+        1.0f));
+    float spread = std::asin(radius / centerDistance);
+    if (angle - spread > candidate.cutoff) {
+      return 0.0f;
+    }
+  }
+
+  return candidate.intensity * attenuation;
+}
+
+/**
+ * @brief Selects the most influential lights for a draw and binds them.
+ *
+ * Lights that stay selected keep their slot, so only slots whose light
+ * changed are specified again. When a slot changes the modelview matrix is
+ * set to the camera view, so the caller must load the draw transform after
+ * this call.
+ *
+ * @param center The view-space center of the draw bounds.
+ * @param radius The radius of the draw bounds.
+ * @param view The camera view matrix.
+ */
+void LightSelector::update(const glm::vec3& center, float radius,
+                           const glm::mat4& view) {
+  Selection selected[MAX_LIGHTS];
+  int count = 0;
+
+  for (int i = 0; i < static_cast<int>(candidates.size()); i++) {
+    float distance;
+    float value = score(candidates[i], center, radius, distance);
+    if (value <= 0.0f) {
+      continue;
+    }
+
+    // Insertion into the sorted top list, closer lights win ties
+    int position = count;
+    while (position > 0 &&
+           (value > selected[position - 1].score ||
+            (value == selected[position - 1].score &&
+             distance < selected[position - 1].distance))) {
+      position--;
+    }
+    if (position == MAX_LIGHTS) {
+      continue;
+    }
+
+    count = std::min(count + 1, MAX_LIGHTS);
+    for (int j = count - 1; j > position; j--) {
+      selected[j] = selected[j - 1];
+    }
+    selected[position] = {i, value, distance};
+  }
+
+  bool kept[MAX_LIGHTS] = {false};
+  bool placed[MAX_LIGHTS] = {false};
+  for (int slot = 0; slot < MAX_LIGHTS; slot++) {
+    for (int i = 0; i < count; i++) {
+      if (slots[slot] == selected[i].candidate) {
+        kept[slot] = true;
+        placed[i] = true;
+      }
+    }
+  }
+
+  int freeSlot = 0;
+  for (int i = 0; i < count; i++) {
+    if (placed[i]) {
+      continue;
+    }
+    while (kept[freeSlot]) {
+      freeSlot++;
+    }
+    slots[freeSlot] = selected[i].candidate;
+    kept[freeSlot] = true;
+    dirty[freeSlot] = true;
+  }
+
+  bool viewLoaded = false;
+  for (int slot = 0; slot < MAX_LIGHTS; slot++) {
+    if (!kept[slot]) {
+      if (slots[slot] >= 0) {
+        StateCache::disable(GL_LIGHT0 + slot);
+        slots[slot] = -1;
+      }
+      dirty[slot] = false;
+      continue;
+    }
+
+    if (dirty[slot]) {
+      if (!viewLoaded) {
+        StateCache::loadModelView(view);
+        viewLoaded = true;
+      }
+      candidates[slots[slot]].light->render(slot);
+      dirty[slot] = false;
+      rebinds++;
+    }
+  }
+
+  maxActiveLights = std::max(maxActiveLights, static_cast<uint32_t>(count));
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Light;
+
+class LightSelector {
+ public:
+  static constexpr int MAX_LIGHTS = 8;
+
+ private:
+  struct Candidate {
+    Light* light;
+    glm::vec3 position;
+    glm::vec3 direction;
+    float cosCutoff;
+    float cutoff;
+    float range;
+    float intensity;
+    bool directional;
+  };
+
+  struct Selection {
+    int candidate;
+    float score;
+    float distance;
+  };
+
+  std::vector<Candidate> candidates;
+  int slots[MAX_LIGHTS];
+  bool dirty[MAX_LIGHTS];
+  uint32_t rebinds = 0;
+  uint32_t maxActiveLights = 0;
+
+  float score(const Candidate& candidate, const glm::vec3& center,
+              float radius, float& distance) const;
+
+ public:
+  LightSelector() { reset(); }
+  void reset();
+  void begin(std::vector<Light>& lights, const glm::mat4& view);
+  void update(const glm::vec3& center, float radius, const glm::mat4& view);
+  uint32_t getRebinds() const { return rebinds; }
+  uint32_t getMaxActiveLights() const { return maxActiveLights; }
+};
@@ -0,0 +1,92 @@
+#include "OffscreenTarget.hpp"
+
+#include <cstdio>
+#include <vector>
+
+#include "debug/Logger.hpp"
+
+static debug::Logger logger;
+
+/**
+ * @brief Creates the framebuffer frames are rendered into when there is no
+ * window to present them.
+ *
+ * @param width The width of the frames in pixels.
+ * @param height The height of the frames in pixels.
+ * @return true if the framebuffer is complete.
+ */
+bool OffscreenTarget::initialize(int width, int height) {
+  this->width = width;
+  this->height = height;
+
+  glGenRenderbuffers(1, &colorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, colorBuffer);
+  // The overdraw view counts fragments in the stencil bits
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, depthBuffer);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    logger.error("Offscreen framebuffer is incomplete.");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return false;
+  }
+
+  return true;
+}
+
+void OffscreenTarget::bind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+/**
+ * @brief Reads back the last rendered frame and writes it as a binary PPM.
+ *
+ * @param path The path of the image file.
+ * @return true if the image was written.
+ */
+bool OffscreenTarget::writePPM(const std::string& path) const {
+  std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    logger.error("Failed to open " + path + " for writing.");
+    return false;
+  }
+
+  // GL rows start at the bottom, PPM rows at the top
+  std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+  for (int row = height - 1; row >= 0; row--) {
+    std::fwrite(pixels.data() + static_cast<size_t>(row) * width * 3, 1,
+                static_cast<size_t>(width) * 3, file);
+  }
+  std::fclose(file);
+
+  return true;
+}
+
+/**
+ * @brief Forgets the framebuffer and its attachments.
+ *
+ * This does not delete them, it must be called once the GL context owning
+ * them has been destroyed.
+ */
+void OffscreenTarget::reset() {
+  framebuffer = 0;
+  colorBuffer = 0;
+  depthBuffer = 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+
+class OffscreenTarget {
+ private:
+  GLuint framebuffer = 0;
+  GLuint colorBuffer = 0;
+  GLuint depthBuffer = 0;
+  int width = 0;
+  int height = 0;
+
+ public:
+  bool initialize(int width, int height);
+  void bind() const;
+  bool writePPM(const std::string& path) const;
+  void reset();
+  bool isInitialized() const { return framebuffer != 0; }
+};
@@ -0,0 +1,190 @@
+#include "OverdrawView.hpp"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Shader.hpp"
+#include "StateCache.hpp"
+
+// From one fragment per pixel up to LEVELS or more
+static const glm::vec3 HEATMAP[OverdrawView::LEVELS] = {
+    {0.0f, 0.0f, 0.5f}, {0.0f, 0.3f, 1.0f}, {0.0f, 0.8f, 0.8f},
+    {0.0f, 0.8f, 0.0f}, {0.9f, 0.9f, 0.0f}, {1.0f, 0.5f, 0.0f},
+    {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+
+// Counter-clockwise, so face culling keeps it
+static const float QUAD[] = {-1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f,
+                             1.0f,  1.0f,  0.0f, -1.0f, 1.0f, 0.0f};
+
+/**
+ * @brief Starts counting the fragments of the scene in the stencil buffer.
+ *
+ * Only fragments that pass the depth test are counted, since those are the
+ * ones that get shaded, so the counts respond to depth prepasses and to the
+ * draw order as well as to culling.
+ */
+void OverdrawView::begin() {
+  glStencilMask(0xFF);
+  glClearStencil(0);
+  glClear(GL_STENCIL_BUFFER_BIT);
+
+  StateCache::enable(GL_STENCIL_TEST);
+  glStencilFunc(GL_ALWAYS, 0, 0xFF);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+}
+
+/**
+ * @brief Stops counting, reads the counts back and draws them as a heatmap
+ * over the scene.
+ *
+ * @param core Whether the core profile renderer is active.
+ * @param width The width of the framebuffer in pixels.
+ * @param height The height of the framebuffer in pixels.
+ */
+void OverdrawView::end(bool core, int width, int height) {
+  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+  measure(width, height);
+  drawHeatmap(core);
+
+  glStencilFunc(GL_ALWAYS, 0, 0xFF);
+  StateCache::disable(GL_STENCIL_TEST);
+}
+
+/**
+ * @brief Reads the stencil buffer back and sums the counts.
+ *
+ * The read waits for the frame to finish, which is acceptable for a debug
+ * view. Counts saturate at 255.
+ */
+void OverdrawView::measure(int width, int height) {
+  pixels = static_cast<uint64_t>(std::max(width, 0)) * std::max(height, 0);
+  counts.resize(pixels);
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE,
+               counts.data());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+  fragments = 0;
+  coveredPixels = 0;
+  maxCount = 0;
+  for (uint8_t count : counts) {
+    fragments += count;
+    coveredPixels += count > 0;
+    maxCount = std::max<uint32_t>(maxCount, count);
+  }
+}
+
+/**
+ * @brief Fills every pixel the scene covered with the color of its count.
+ *
+ * A fullscreen quad is drawn once per level, the stencil test picks the
+ * pixels of that level.
+ *
+ * @param core Whether the core profile renderer is active.
+ */
+void OverdrawView::drawHeatmap(bool core) {
+  if (quadBuffer == 0) {
+    glGenBuffers(1, &quadBuffer);
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+  }
+
+  if (core && program == 0) {
+    if (programFailed) {
+      return;
+    }
+    // The debug line program draws a constant color just as well
+    program = loadProgram("engine/assets/shaders/debug.vert",
+                          "engine/assets/shaders/debug.frag");
+    if (program == 0) {
+      programFailed = true;
+      return;
+    }
+    modelViewProjectionLocation =
+        glGetUniformLocation(program, "modelViewProjection");
+    glGenVertexArrays(1, &vertexArray);
+  }
+
+  bool depthTest = StateCache::isEnabled(GL_DEPTH_TEST);
+  bool lighting = false;
+  StateCache::disable(GL_DEPTH_TEST);
+  StateCache::bindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+
+  if (core) {
+    glm::mat4 identity(1.0f);
+    glUseProgram(program);
+    glBindVertexArray(vertexArray);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glDisableVertexAttribArray(1);
+    glUniformMatrix4fv(modelViewProjectionLocation, 1, GL_FALSE,
+                       glm::value_ptr(identity));
+  } else {
+    lighting = StateCache::isEnabled(GL_LIGHTING);
+    StateCache::disable(GL_LIGHTING);
+    StateCache::disable(GL_TEXTURE_2D);
+    StateCache::enableClientState(GL_VERTEX_ARRAY);
+    StateCache::disableClientState(GL_NORMAL_ARRAY);
+    StateCache::disableClientState(GL_TEXTURE_COORD_ARRAY);
+    StateCache::disableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+
+    // The quad is already in clip space
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+  }
+
+  for (int level = 1; level <= LEVELS; level++) {
+    const glm::vec3& color = HEATMAP[level - 1];
+    if (core) {
+      glVertexAttrib3f(1, color.r, color.g, color.b);
+    } else {
+      glColor3f(color.r, color.g, color.b);
+    }
+    glStencilFunc(level == LEVELS ? GL_LEQUAL : GL_EQUAL, level, 0xFF);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  }
+
+  if (core) {
+    glBindVertexArray(0);
+    glUseProgram(0);
+  } else {
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    if (lighting) {
+      StateCache::enable(GL_LIGHTING);
+    }
+  }
+
+  if (depthTest) {
+    StateCache::enable(GL_DEPTH_TEST);
+  }
+}
+
+/**
+ * @brief Forgets the quad buffer and the program.
+ *
+ * This does not delete them, it must be called once the GL context owning
+ * them has been destroyed.
+ */
+void OverdrawView::reset() {
+  quadBuffer = 0;
+  program = 0;
+  vertexArray = 0;
+  modelViewProjectionLocation = -1;
+  programFailed = false;
+  fragments = 0;
+  coveredPixels = 0;
+  pixels = 0;
+  maxCount = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+class OverdrawView {
+ public:
+  // Pixels drawn this many times or more share the hottest color
+  static constexpr int LEVELS = 8;
+
+ private:
+  GLuint quadBuffer = 0;
+  GLuint program = 0;
+  GLuint vertexArray = 0;
+  GLint modelViewProjectionLocation = -1;
+  bool programFailed = false;
+  std::vector<uint8_t> counts;
+  uint64_t fragments = 0;
+  uint64_t coveredPixels = 0;
+  uint64_t pixels = 0;
+  uint32_t maxCount = 0;
+
+  void measure(int width, int height);
+  void drawHeatmap(bool core);
+
+ public:
+  void begin();
+  void end(bool core, int width, int height);
+  void reset();
+  // Fragments shaded per pixel the scene covers
+  double getAverage() const {
+    return coveredPixels > 0 ? static_cast<double>(fragments) / coveredPixels
+                             : 0.0;
+  }
+  // Fragments shaded per pixel of the whole frame
+  double getScreenAverage() const {
+    return pixels > 0 ? static_cast<double>(fragments) / pixels : 0.0;
+  }
+  float getCoverage() const {
+    return pixels > 0 ? static_cast<float>(coveredPixels) / pixels : 0.0f;
+  }
+  uint32_t getMax() const { return maxCount; }
+};
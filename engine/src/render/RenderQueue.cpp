@@ -0,0 +1,378 @@
+#include "RenderQueue.hpp"
+
+#include <chrono>
+#include <limits>
+
+#include "GeometryHeap.hpp"
+#include "LightSelector.hpp"
+#include "StateCache.hpp"
+#include "scene/Model.hpp"
+
+// Sort key layout, most significant bits first, the top 8 bits are unused:
+// [ 16 bits texture | 16 bits material | 24 bits depth ]
+static constexpr int DEPTH_BITS = 24;
+static constexpr int MATERIAL_SHIFT = DEPTH_BITS;
+static constexpr int TEXTURE_SHIFT = MATERIAL_SHIFT + 16;
+static constexpr uint32_t DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+
+/**
+ * @brief Builds the 64-bit sort key of a draw packet.
+ *
+ * Packets are grouped by texture first, then by material, since those are the
+ * most expensive state changes. Inside a state bucket the depth bits order the
+ * draws front to back, so opaque geometry benefits from early depth rejection.
+ *
+ * @param texture The interned texture id of the draw (0 if untextured).
+ * @param material The interned material id of the draw.
+ * @param depth The quantized view-space depth of the draw.
+ * @return The sort key.
+ */
+uint64_t makeSortKey(uint16_t texture, uint16_t material, uint32_t depth) {
+  return (static_cast<uint64_t>(texture) << TEXTURE_SHIFT) |
+         (static_cast<uint64_t>(material) << MATERIAL_SHIFT) |
+         static_cast<uint64_t>(depth & DEPTH_MAX);
+}
+
+/**
+ * @brief Sorts draw packets by key using an LSD radix sort.
+ *
+ * The keys are processed one byte at a time. Passes where every key shares the
+ * same byte are skipped, which is always the case for the unused top byte and
+ * common for scenes with few textures and materials.
+ *
+ * @param packets The packets to sort, sorted in place.
+ * @param scratch A scratch buffer reused between frames.
+ */
+void radixSort(std::vector<DrawPacket>& packets,
+               std::vector<DrawPacket>& scratch) {
+  const size_t count = packets.size();
+  if (count < 2) {
+    return;
+  }
+
+  scratch.resize(count);
+
+  for (int shift = 0; shift < 64; shift += 8) {
+    size_t histogram[256] = {0};
+    for (const DrawPacket& packet : packets) {
+      histogram[(packet.key >> shift) & 0xFF]++;
+    }
+
+    if (histogram[(packets[0].key >> shift) & 0xFF] == count) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (size_t& bucket : histogram) {
+      size_t size = bucket;
+      bucket = offset;
+      offset += size;
+    }
+
+    for (const DrawPacket& packet : packets) {
+      scratch[histogram[(packet.key >> shift) & 0xFF]++] = packet;
+    }
+
+    packets.swap(scratch);
+  }
+}
+
+/**
+ * @brief Starts a new frame of render list extraction.
+ *
+ * @param view The camera view matrix for this frame.
+ * @param projection The camera projection matrix, used for frustum culling.
+ * @param depthRange The distance mapped to the furthest depth bucket.
+ * @param viewportHeight The height of the viewport in pixels.
+ * @param viewMode The active view mode, which decides texture usage.
+ */
+void RenderQueue::begin(const glm::mat4& view, const glm::mat4& projection,
+                        float depthRange, float viewportHeight,
+                        ViewMode viewMode) {
+  this->view = view;
+  this->frustum = Frustum(projection);
+  this->depthRange = depthRange > 0.0f ? depthRange : 1.0f;
+  this->pixelScale = projection[1][1] * viewportHeight * 0.5f;
+  this->viewMode = viewMode;
+  transforms.clear();
+  packets.clear();
+  stats = RenderStats();
+}
+
+/**
+ * @brief Registers a world transform shared by the following draw packets.
+ *
+ * @param world The world matrix of a group.
+ * @return The index of the transform, to be referenced by packets.
+ */
+uint32_t RenderQueue::pushTransform(const glm::mat4& world) {
+  transforms.push_back(view * world);
+  return static_cast<uint32_t>(transforms.size() - 1);
+}
+
+/**
+ * @brief Computes the view-space bounding sphere of a model.
+ *
+ * @param modelView The modelview matrix of the model.
+ * @param model The model.
+ * @param center Receives the view-space center of the sphere.
+ * @return The radius of the sphere, grown by the largest scale of the matrix.
+ */
+static float viewBounds(const glm::mat4& modelView, const Model& model,
+                        glm::vec3& center) {
+  center = glm::vec3(modelView * glm::vec4(model.getBoundsCenter(), 1.0f));
+  float scale = glm::max(glm::length(glm::vec3(modelView[0])),
+                         glm::max(glm::length(glm::vec3(modelView[1])),
+                                  glm::length(glm::vec3(modelView[2]))));
+  return model.getBoundsRadius() * scale;
+}
+
+/**
+ * @brief Emits a draw packet for a model, unless it is outside the frustum.
+ *
+ * @param model The model to draw. It must outlive the frame.
+ * @param transform The index returned by pushTransform.
+ */
+void RenderQueue::push(const Model& model, uint32_t transform) {
+  glm::vec3 center;
+  float radius = viewBounds(transforms[transform], model, center);
+  if (!frustum.intersectsSphere(center, radius)) {
+    stats.culledDraws++;
+    return;
+  }
+
+  float depth = glm::clamp(-center.z / depthRange, 0.0f, 1.0f);
+
+  uint16_t texture =
+      model.usesTexture(viewMode) ? model.getTextureSortId() : 0;
+
+  DrawPacket packet;
+  packet.key = makeSortKey(texture, model.getMaterialId(),
+                           static_cast<uint32_t>(depth * DEPTH_MAX));
+  packet.model = &model;
+  packet.transform = transform;
+  packets.push_back(packet);
+}
+
+void RenderQueue::sort() { radixSort(packets, scratch); }
+
+/**
+ * @brief Writes one indirect draw command per packet and uploads them.
+ *
+ * The base instance of each command is the index of its transform, so a
+ * shader reading the transform from an instanced attribute can draw packets
+ * of different groups in one multi-draw. The buffer is respecified every
+ * frame so the driver can hand out fresh storage instead of waiting on draws
+ * still reading the previous commands. It is left bound to
+ * GL_DRAW_INDIRECT_BUFFER.
+ */
+void RenderQueue::uploadCommands() {
+  // Without base instance support the field is reserved and must be zero
+  bool baseInstance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+
+  commands.resize(packets.size());
+  for (size_t i = 0; i < packets.size(); i++) {
+    const GeometryAllocation& allocation =
+        GeometryHeap::get(packets[i].model->getGeometry());
+    DrawElementsIndirectCommand& command = commands[i];
+    command.count = allocation.indexCount;
+    command.instanceCount = 1;
+    command.firstIndex = allocation.indexOffset;
+    command.baseVertex = static_cast<int32_t>(allocation.vertexOffset);
+    command.baseInstance = baseInstance ? packets[i].transform : 0;
+  }
+
+  if (indirectBuffer == 0) {
+    glGenBuffers(1, &indirectBuffer);
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER,
+               commands.size() * sizeof(DrawElementsIndirectCommand),
+               commands.data(), GL_STREAM_DRAW);
+}
+
+/**
+ * @brief Submits the sorted draw packets to OpenGL.
+ *
+ * Material and texture state is only changed when it differs from the
+ * previous packet, and the remaining binds go through the StateCache. The
+ * modelview matrix is reset to the camera view once all packets are drawn.
+ *
+ * With multi-draw indirect, consecutive packets sharing their state and
+ * transform are drawn by a single glMultiDrawElementsIndirect call. The fixed
+ * function pipeline cannot change the modelview matrix inside a multi-draw,
+ * so packets of different groups still end up in separate calls. The core
+ * renderer reads the transform per draw instead, see CoreRenderer::submit.
+ *
+ * When a light selector is given, the lights bound to the fixed-function
+ * slots are chosen per draw, or per run with multi-draw indirect, from the
+ * bounds of what is drawn.
+ *
+ * @param useMultiDraw Whether to use multi-draw indirect when supported.
+ * @param lights The light selector, or nullptr to leave lights untouched.
+ */
+void RenderQueue::submit(bool useMultiDraw, LightSelector* lights) {
+  auto start = std::chrono::steady_clock::now();
+  uint32_t bufferBinds = StateCache::getBufferBinds();
+  uint32_t textureBinds = StateCache::getTextureBinds();
+
+  stats.multiDrawIndirect =
+      useMultiDraw && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+
+  int currentMaterial = -1;
+  uint32_t currentTexture = 0;
+
+  StateCache::enableClientState(GL_VERTEX_ARRAY);
+  GeometryHeap::bind();
+
+  if (stats.multiDrawIndirect && !packets.empty()) {
+    uploadCommands();
+  }
+
+  size_t i = 0;
+  while (i < packets.size()) {
+    const DrawPacket& packet = packets[i];
+    const Model& model = *packet.model;
+    uint32_t texture = model.usesTexture(viewMode) ? model.getTextureId() : 0;
+
+    size_t runEnd = i + 1;
+    while (stats.multiDrawIndirect && runEnd < packets.size()) {
+      const DrawPacket& next = packets[runEnd];
+      uint32_t nextTexture = next.model->usesTexture(viewMode)
+                                 ? next.model->getTextureId()
+                                 : 0;
+      if (next.transform != packet.transform ||
+          next.model->getMaterialId() != model.getMaterialId() ||
+          nextTexture != texture ||
+          next.model->hasNormalMapping() != model.hasNormalMapping()) {
+        break;
+      }
+      runEnd++;
+    }
+
+    if (lights != nullptr) {
+      // A run shares one selection, picked for a sphere enclosing all of it
+      glm::vec3 center;
+      float radius = viewBounds(transforms[packet.transform], model, center);
+      for (size_t j = i + 1; j < runEnd; j++) {
+        glm::vec3 otherCenter;
+        float otherRadius = viewBounds(transforms[packets[j].transform],
+                                       *packets[j].model, otherCenter);
+        radius = glm::max(radius, glm::length(otherCenter - center) +
+                                      otherRadius);
+      }
+      lights->update(center, radius, view);
+    }
+
+    if (model.getMaterialId() != currentMaterial) {
+      model.applyMaterial();
+      currentMaterial = model.getMaterialId();
+      stats.stateChanges++;
+      stats.materialChanges++;
+    }
+
+    if (texture != currentTexture) {
+      if (texture == 0) {
+        StateCache::disable(GL_TEXTURE_2D);
+      } else {
+        StateCache::enable(GL_TEXTURE_2D);
+        StateCache::bindTexture(GL_TEXTURE_2D, texture);
+      }
+      currentTexture = texture;
+      stats.stateChanges++;
+    }
+
+    stats.stateChanges +=
+        StateCache::setClientState(GL_NORMAL_ARRAY, model.hasNormalMapping());
+    stats.stateChanges +=
+        StateCache::setClientState(GL_TEXTURE_COORD_ARRAY, texture != 0);
+
+    StateCache::loadModelView(transforms[packet.transform]);
+
+    if (!stats.multiDrawIndirect) {
+      model.draw();
+    } else {
+      glMultiDrawElementsIndirect(
+          GL_TRIANGLES, GL_UNSIGNED_INT,
+          reinterpret_cast<void*>(i * sizeof(DrawElementsIndirectCommand)),
+          static_cast<GLsizei>(runEnd - i), 0);
+      stats.indirectCommands += static_cast<uint32_t>(runEnd - i);
+    }
+    for (size_t j = i; j < runEnd; j++) {
+      stats.triangles += packets[j].model->getIndexCount() / 3;
+      stats.vertices += packets[j].model->getVertexCount();
+    }
+    stats.drawCalls++;
+    i = runEnd;
+  }
+
+  if (lights != nullptr) {
+    stats.lightRebinds = lights->getRebinds();
+    stats.activeLights = lights->getMaxActiveLights();
+  }
+
+  if (stats.multiDrawIndirect) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  // Lines drawn after the scene must not be textured
+  StateCache::disable(GL_TEXTURE_2D);
+
+  StateCache::loadModelView(view);
+
+  stats.bufferBinds = StateCache::getBufferBinds() - bufferBinds;
+  stats.textureBinds = StateCache::getTextureBinds() - textureBinds;
+
+  auto end = std::chrono::steady_clock::now();
+  stats.submitMilliseconds =
+      std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * @brief Queues the normal lines of every extracted draw on the debug-draw
+ * system.
+ *
+ * @param scale The length of the normal lines.
+ */
+void RenderQueue::renderNormals(float scale) const {
+  for (const DrawPacket& packet : packets) {
+    packet.model->renderNormals(transforms[packet.transform], scale);
+  }
+}
+
+/**
+ * @brief Checks whether a world space sphere intersects the view frustum.
+ *
+ * @param center The center of the sphere in world space.
+ * @param radius The radius of the sphere.
+ * @return true if the sphere may be visible.
+ */
+bool RenderQueue::isVisible(const glm::vec3& center, float radius) const {
+  glm::vec3 viewCenter = glm::vec3(view * glm::vec4(center, 1.0f));
+  return frustum.intersectsSphere(viewCenter, radius);
+}
+
+/**
+ * @brief Estimates the projected radius of a world space sphere.
+ *
+ * @param center The center of the sphere in world space.
+ * @param radius The radius of the sphere.
+ * @return The radius in pixels, infinite if the camera is inside the sphere.
+ */
+float RenderQueue::getPixelRadius(const glm::vec3& center,
+                                  float radius) const {
+  glm::vec3 viewCenter = glm::vec3(view * glm::vec4(center, 1.0f));
+  float distance = glm::length(viewCenter);
+  if (distance <= radius) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return radius * pixelScale / distance;
+}
+
+/**
+ * @brief Forgets the indirect command buffer.
+ *
+ * This does not delete the buffer, it must be called once the GL context
+ * owning it has been destroyed.
+ */
+void RenderQueue::reset() { indirectBuffer = 0; }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Frustum.hpp"
+#include "RenderStats.hpp"
+#include "engine/Settings.hpp"
+
+class LightSelector;
+class Model;
+
+struct DrawPacket {
+  uint64_t key;
+  const Model* model;
+  uint32_t transform;
+};
+
+struct DrawElementsIndirectCommand {
+  uint32_t count;
+  uint32_t instanceCount;
+  uint32_t firstIndex;
+  int32_t baseVertex;
+  uint32_t baseInstance;
+};
+
+class RenderQueue {
+ private:
+  glm::mat4 view = glm::mat4(1.0f);
+  Frustum frustum;
+  float depthRange = 1.0f;
+  float pixelScale = 1.0f;
+  ViewMode viewMode = SHADED;
+  std::vector<glm::mat4> transforms;
+  std::vector<DrawPacket> packets;
+  std::vector<DrawPacket> scratch;
+  std::vector<DrawElementsIndirectCommand> commands;
+  GLuint indirectBuffer = 0;
+  RenderStats stats;
+
+ public:
+  void begin(const glm::mat4& view, const glm::mat4& projection,
+             float depthRange, float viewportHeight, ViewMode viewMode);
+  uint32_t pushTransform(const glm::mat4& world);
+  void push(const Model& model, uint32_t transform);
+  void sort();
+  void uploadCommands();
+  void submit(bool useMultiDraw, LightSelector* lights);
+  void renderNormals(float scale) const;
+  bool isVisible(const glm::vec3& center, float radius) const;
+  float getPixelRadius(const glm::vec3& center, float radius) const;
+  void countGroup() { stats.groupsTraversed++; }
+  void countAnimations(uint32_t evaluated, uint32_t deferred) {
+    stats.animationsEvaluated += evaluated;
+    stats.animationsDeferred += deferred;
+  }
+  void reset();
+  const glm::mat4& getView() const { return view; }
+  ViewMode getViewMode() const { return viewMode; }
+  const glm::mat4& getTransform(uint32_t transform) const {
+    return transforms[transform];
+  }
+  size_t getTransformCount() const { return transforms.size(); }
+  const std::vector<DrawPacket>& getPackets() const { return packets; }
+  const RenderStats& getStats() const { return stats; }
+  size_t getPacketCount() const { return packets.size(); }
+};
+
+uint64_t makeSortKey(uint16_t texture, uint16_t material, uint32_t depth);
+void radixSort(std::vector<DrawPacket>& packets,
+               std::vector<DrawPacket>& scratch);
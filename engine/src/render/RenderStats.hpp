@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+struct RenderStats {
+  uint32_t drawCalls = 0;
+  uint64_t triangles = 0;
+  uint64_t vertices = 0;
+  uint32_t stateChanges = 0;
+  uint32_t materialChanges = 0;
+  // Binds issued through the StateCache while submitting, by either renderer
+  uint32_t bufferBinds = 0;
+  uint32_t textureBinds = 0;
+  uint32_t culledDraws = 0;
+  uint32_t groupsTraversed = 0;
+  uint32_t indirectCommands = 0;
+  bool multiDrawIndirect = false;
+  double submitMilliseconds = 0.0;
+  uint32_t lights = 0;
+  uint32_t activeLights = 0;
+  uint32_t maxClusterLights = 0;
+  double lightBinningMilliseconds = 0.0;
+  uint32_t lightRebinds = 0;
+  uint32_t animationsEvaluated = 0;
+  uint32_t animationsDeferred = 0;
+};
+
+/**
+ * @brief Calls a function with the name and value of every frame counter.
+ *
+ * Lets tools such as the benchmark report every counter without listing
+ * them. Names are snake_case, as in the JSON reports.
+ *
+ * @param stats The statistics of a frame.
+ * @param visit The function, called as visit(const char* name, double value).
+ */
+template <typename Visitor>
+void forEachCounter(const RenderStats& stats, Visitor visit) {
+  visit("draw_calls", stats.drawCalls);
+  visit("triangles", static_cast<double>(stats.triangles));
+  visit("vertices", static_cast<double>(stats.vertices));
+  visit("state_changes", stats.stateChanges);
+  visit("material_changes", stats.materialChanges);
+  visit("buffer_binds", stats.bufferBinds);
+  visit("texture_binds", stats.textureBinds);
+  visit("active_lights", stats.activeLights);
+  visit("groups_traversed", stats.groupsTraversed);
+  visit("models_culled", stats.culledDraws);
+  visit("animations_evaluated", stats.animationsEvaluated);
+  visit("animations_deferred", stats.animationsDeferred);
+}
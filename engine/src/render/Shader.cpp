@@ -0,0 +1,82 @@
+#include "Shader.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#include "debug/Logger.hpp"
+
+static debug::Logger logger;
+
+/**
+ * @brief Compiles a shader stage from a source file.
+ *
+ * @param type The shader stage.
+ * @param path The path of the GLSL source file.
+ * @return The shader object, or 0 if it could not be read or compiled.
+ */
+static GLuint compileShader(GLenum type, const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    logger.error("Failed to open shader: " + path + ".");
+    return 0;
+  }
+
+  std::stringstream source;
+  source << file.rdbuf();
+  std::string code = source.str();
+  const char* codePointer = code.c_str();
+
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &codePointer, nullptr);
+  glCompileShader(shader);
+
+  GLint compiled;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+  if (!compiled) {
+    char log[1024];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    logger.error("Failed to compile shader " + path + ": " + log);
+    glDeleteShader(shader);
+    return 0;
+  }
+
+  return shader;
+}
+
+/**
+ * @brief Compiles and links a program from a vertex and a fragment shader.
+ *
+ * @param vertexPath The path of the vertex shader source.
+ * @param fragmentPath The path of the fragment shader source.
+ * @return The program object, or 0 if a stage failed to compile or link.
+ */
+GLuint loadProgram(const std::string& vertexPath,
+                   const std::string& fragmentPath) {
+  GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexPath);
+  GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentPath);
+  if (vertexShader == 0 || fragmentShader == 0) {
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return 0;
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader(program, vertexShader);
+  glAttachShader(program, fragmentShader);
+  glLinkProgram(program);
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+
+  GLint linked;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    char log[1024];
+    glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+    logger.error("Failed to link " + vertexPath + " and " + fragmentPath +
+                 ": " + log);
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  return program;
+}
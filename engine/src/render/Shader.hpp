@@ -0,0 +1,8 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+
+GLuint loadProgram(const std::string& vertexPath,
+                   const std::string& fragmentPath);
@@ -0,0 +1,326 @@
+#include "StateCache.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+StateCache::Capability StateCache::capabilities[MAX_CAPABILITIES];
+int StateCache::capabilityCount = 0;
+StateCache::Capability StateCache::clientStates[MAX_CAPABILITIES];
+int StateCache::clientStateCount = 0;
+GLuint StateCache::arrayBuffer = UNKNOWN_BINDING;
+GLuint StateCache::elementArrayBuffer = UNKNOWN_BINDING;
+GLuint StateCache::texture2D = UNKNOWN_BINDING;
+StateCache::Parameter StateCache::materialParameters[MATERIAL_PARAMETERS];
+StateCache::Parameter StateCache::lightParameters[MAX_LIGHTS]
+                                                [LIGHT_PARAMETERS];
+glm::mat4 StateCache::modelView = glm::mat4(1.0f);
+bool StateCache::modelViewKnown = false;
+uint32_t StateCache::issuedCalls = 0;
+uint32_t StateCache::skippedCalls = 0;
+uint32_t StateCache::lastIssuedCalls = 0;
+uint32_t StateCache::lastSkippedCalls = 0;
+uint32_t StateCache::bufferBinds = 0;
+uint32_t StateCache::textureBinds = 0;
+
+static int materialParameterIndex(GLenum pname) {
+  switch (pname) {
+    case GL_AMBIENT:
+      return 0;
+    case GL_DIFFUSE:
+      return 1;
+    case GL_SPECULAR:
+      return 2;
+    case GL_EMISSION:
+      return 3;
+    case GL_SHININESS:
+      return 4;
+    default:
+      return -1;
+  }
+}
+
+static int lightParameterIndex(GLenum pname) {
+  switch (pname) {
+    case GL_DIFFUSE:
+      return 0;
+    case GL_SPECULAR:
+      return 1;
+    case GL_POSITION:
+      return 2;
+    case GL_SPOT_DIRECTION:
+      return 3;
+    case GL_SPOT_CUTOFF:
+      return 4;
+    case GL_QUADRATIC_ATTENUATION:
+      return 5;
+    default:
+      return -1;
+  }
+}
+
+/**
+ * @brief Forgets all tracked state.
+ *
+ * Must be called whenever a new GL context is made current, or after any code
+ * that changes tracked state without going through the cache.
+ */
+void StateCache::invalidate() {
+  capabilityCount = 0;
+  clientStateCount = 0;
+  arrayBuffer = UNKNOWN_BINDING;
+  elementArrayBuffer = UNKNOWN_BINDING;
+  texture2D = UNKNOWN_BINDING;
+  modelViewKnown = false;
+
+  for (Parameter& parameter : materialParameters) {
+    parameter.known = false;
+  }
+  for (auto& light : lightParameters) {
+    for (Parameter& parameter : light) {
+      parameter.known = false;
+    }
+  }
+}
+
+/**
+ * @brief Starts a new frame of call counters.
+ *
+ * The counters of the previous frame stay available through getIssuedCalls
+ * and getSkippedCalls.
+ */
+void StateCache::beginFrame() {
+  lastIssuedCalls = issuedCalls;
+  lastSkippedCalls = skippedCalls;
+  issuedCalls = 0;
+  skippedCalls = 0;
+}
+
+/**
+ * @brief Updates a capability in a tracking table.
+ *
+ * @param table The table of tracked capabilities.
+ * @param count The number of tracked capabilities in the table.
+ * @param cap The capability to update.
+ * @param enabled The requested state.
+ * @param clientState Whether the capability is a client array.
+ * @return true if a GL call was issued, false if it was redundant.
+ */
+bool StateCache::setCapability(Capability* table, int& count, GLenum cap,
+                               bool enabled, bool clientState) {
+  Capability* entry = nullptr;
+  for (int i = 0; i < count; i++) {
+    if (table[i].cap == cap) {
+      entry = &table[i];
+      break;
+    }
+  }
+
+  if (entry != nullptr && entry->enabled == enabled) {
+    skippedCalls++;
+    return false;
+  }
+
+  if (entry == nullptr && count < MAX_CAPABILITIES) {
+    entry = &table[count++];
+    entry->cap = cap;
+  }
+
+  if (entry != nullptr) {
+    entry->enabled = enabled;
+  }
+
+  if (clientState) {
+    enabled ? glEnableClientState(cap) : glDisableClientState(cap);
+  } else {
+    enabled ? glEnable(cap) : glDisable(cap);
+  }
+  issuedCalls++;
+  return true;
+}
+
+bool StateCache::setEnabled(GLenum cap, bool enabled) {
+  return setCapability(capabilities, capabilityCount, cap, enabled, false);
+}
+
+/**
+ * @brief Returns whether a capability is enabled.
+ *
+ * Tracked capabilities are answered from the cache, others fall back to
+ * glIsEnabled.
+ *
+ * @param cap The capability to query.
+ * @return true if the capability is enabled.
+ */
+bool StateCache::isEnabled(GLenum cap) {
+  for (int i = 0; i < capabilityCount; i++) {
+    if (capabilities[i].cap == cap) {
+      return capabilities[i].enabled;
+    }
+  }
+  return glIsEnabled(cap) == GL_TRUE;
+}
+
+bool StateCache::setClientState(GLenum array, bool enabled) {
+  return setCapability(clientStates, clientStateCount, array, enabled, true);
+}
+
+/**
+ * @brief Binds a buffer object unless it is already bound to the target.
+ *
+ * @param target GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER. Other targets are
+ * not tracked and always bound.
+ * @param buffer The buffer object to bind.
+ * @return true if a GL call was issued, false if it was redundant.
+ */
+bool StateCache::bindBuffer(GLenum target, GLuint buffer) {
+  GLuint* binding = target == GL_ARRAY_BUFFER           ? &arrayBuffer
+                    : target == GL_ELEMENT_ARRAY_BUFFER ? &elementArrayBuffer
+                                                        : nullptr;
+
+  if (binding != nullptr && *binding == buffer) {
+    skippedCalls++;
+    return false;
+  }
+
+  glBindBuffer(target, buffer);
+  bufferBinds++;
+  if (binding != nullptr) {
+    *binding = buffer;
+  }
+  issuedCalls++;
+  return true;
+}
+
+/**
+ * @brief Binds a range of a buffer object to an indexed binding point.
+ *
+ * Indexed bindings are not tracked, the call is always issued. It goes
+ * through the cache so that it is counted with the other buffer binds.
+ */
+void StateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                                 GLintptr offset, GLsizeiptr size) {
+  glBindBufferRange(target, index, buffer, offset, size);
+  bufferBinds++;
+  issuedCalls++;
+}
+
+/**
+ * @brief Binds a texture unless it is already bound to the target.
+ *
+ * @param target The texture target. Only GL_TEXTURE_2D is tracked.
+ * @param texture The texture object to bind.
+ * @return true if a GL call was issued, false if it was redundant.
+ */
+bool StateCache::bindTexture(GLenum target, GLuint texture) {
+  if (target == GL_TEXTURE_2D && texture2D == texture) {
+    skippedCalls++;
+    return false;
+  }
+
+  glBindTexture(target, texture);
+  textureBinds++;
+  if (target == GL_TEXTURE_2D) {
+    texture2D = texture;
+  }
+  issuedCalls++;
+  return true;
+}
+
+/**
+ * @brief Compares a parameter with its cached value and updates the cache.
+ *
+ * Positional parameters (light positions and spot directions) are transformed
+ * by the modelview matrix when they are set, so they are only redundant if the
+ * modelview matrix is also unchanged.
+ *
+ * @param parameter The cached parameter.
+ * @param values The new values.
+ * @param count The number of values.
+ * @param positional Whether the parameter depends on the modelview matrix.
+ * @return true if the parameter changed and must be sent to GL.
+ */
+bool StateCache::setParameter(Parameter& parameter, const float* values,
+                              int count, bool positional) {
+  glm::vec4 value(0.0f);
+  for (int i = 0; i < count; i++) {
+    value[i] = values[i];
+  }
+
+  bool redundant = parameter.known && parameter.value == value;
+  if (positional) {
+    redundant = redundant && modelViewKnown && parameter.modelView == modelView;
+  }
+
+  if (redundant) {
+    skippedCalls++;
+    return false;
+  }
+
+  parameter.value = value;
+  parameter.modelView = modelView;
+  parameter.known = true;
+  return true;
+}
+
+bool StateCache::material(GLenum face, GLenum pname, const float* values) {
+  int index = materialParameterIndex(pname);
+  if (face == GL_FRONT && index >= 0 &&
+      !setParameter(materialParameters[index], values,
+                    pname == GL_SHININESS ? 1 : 4, false)) {
+    return false;
+  }
+
+  glMaterialfv(face, pname, values);
+  issuedCalls++;
+  return true;
+}
+
+bool StateCache::materialf(GLenum face, GLenum pname, float value) {
+  return material(face, pname, &value);
+}
+
+bool StateCache::light(GLenum light, GLenum pname, const float* values) {
+  int lightIndex = static_cast<int>(light) - GL_LIGHT0;
+  int index = lightParameterIndex(pname);
+  if (lightIndex >= 0 && lightIndex < MAX_LIGHTS && index >= 0) {
+    int count = 4;
+    if (pname == GL_SPOT_DIRECTION) {
+      count = 3;
+    } else if (pname == GL_SPOT_CUTOFF || pname == GL_QUADRATIC_ATTENUATION) {
+      count = 1;
+    }
+    bool positional = pname == GL_POSITION || pname == GL_SPOT_DIRECTION;
+    if (!setParameter(lightParameters[lightIndex][index], values, count,
+                      positional)) {
+      return false;
+    }
+  }
+
+  glLightfv(light, pname, values);
+  issuedCalls++;
+  return true;
+}
+
+bool StateCache::lightf(GLenum light, GLenum pname, float value) {
+  return StateCache::light(light, pname, &value);
+}
+
+/**
+ * @brief Loads a matrix into the modelview stack unless it is already loaded.
+ *
+ * The caller must have GL_MODELVIEW as the current matrix mode.
+ *
+ * @param matrix The matrix to load.
+ * @return true if a GL call was issued, false if it was redundant.
+ */
+bool StateCache::loadModelView(const glm::mat4& matrix) {
+  if (modelViewKnown && modelView == matrix) {
+    skippedCalls++;
+    return false;
+  }
+
+  glLoadMatrixf(glm::value_ptr(matrix));
+  modelView = matrix;
+  modelViewKnown = true;
+  issuedCalls++;
+  return true;
+}
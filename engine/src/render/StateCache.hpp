@@ -0,0 +1,84 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class StateCache {
+  static constexpr int MAX_CAPABILITIES = 32;
+  static constexpr int MAX_LIGHTS = 8;
+  static constexpr int MATERIAL_PARAMETERS = 5;
+  static constexpr int LIGHT_PARAMETERS = 6;
+  static constexpr GLuint UNKNOWN_BINDING = UINT32_MAX;
+
+  struct Capability {
+    GLenum cap;
+    bool enabled;
+  };
+
+  struct Parameter {
+    glm::vec4 value;
+    glm::mat4 modelView;
+    bool known;
+  };
+
+  static Capability capabilities[MAX_CAPABILITIES];
+  static int capabilityCount;
+  static Capability clientStates[MAX_CAPABILITIES];
+  static int clientStateCount;
+  static GLuint arrayBuffer;
+  static GLuint elementArrayBuffer;
+  static GLuint texture2D;
+  static Parameter materialParameters[MATERIAL_PARAMETERS];
+  static Parameter lightParameters[MAX_LIGHTS][LIGHT_PARAMETERS];
+  static glm::mat4 modelView;
+  static bool modelViewKnown;
+
+  static uint32_t issuedCalls;
+  static uint32_t skippedCalls;
+  static uint32_t lastIssuedCalls;
+  static uint32_t lastSkippedCalls;
+  static uint32_t bufferBinds;
+  static uint32_t textureBinds;
+
+  static bool setCapability(Capability* table, int& count, GLenum cap,
+                            bool enabled, bool clientState);
+  static bool setParameter(Parameter& parameter, const float* values,
+                           int count, bool positional);
+
+ public:
+  static void invalidate();
+  static void beginFrame();
+
+  static bool enable(GLenum cap) { return setEnabled(cap, true); }
+  static bool disable(GLenum cap) { return setEnabled(cap, false); }
+  static bool setEnabled(GLenum cap, bool enabled);
+  static bool isEnabled(GLenum cap);
+
+  static bool enableClientState(GLenum array) {
+    return setClientState(array, true);
+  }
+  static bool disableClientState(GLenum array) {
+    return setClientState(array, false);
+  }
+  static bool setClientState(GLenum array, bool enabled);
+
+  static bool bindBuffer(GLenum target, GLuint buffer);
+  static void bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                              GLintptr offset, GLsizeiptr size);
+  static bool bindTexture(GLenum target, GLuint texture);
+
+  static bool material(GLenum face, GLenum pname, const float* values);
+  static bool materialf(GLenum face, GLenum pname, float value);
+  static bool light(GLenum light, GLenum pname, const float* values);
+  static bool lightf(GLenum light, GLenum pname, float value);
+
+  static bool loadModelView(const glm::mat4& matrix);
+
+  static uint32_t getIssuedCalls() { return lastIssuedCalls; }
+  static uint32_t getSkippedCalls() { return lastSkippedCalls; }
+  // Running totals, callers count the binds of a pass by difference
+  static uint32_t getBufferBinds() { return bufferBinds; }
+  static uint32_t getTextureBinds() { return textureBinds; }
+};
@@ -0,0 +1,172 @@
+#include "StaticBatch.hpp"
+
+#include <chrono>
+#include <map>
+#include <tuple>
+
+#include "debug/Logger.hpp"
+#include "scene/Group.hpp"
+
+static debug::Logger logger;
+
+// Models can only share a batch if they bind the same state and attributes
+using BatchKey = std::tuple<uint16_t, uint32_t, bool, bool>;
+
+static BatchKey makeBatchKey(const Model& model) {
+  return BatchKey(model.getMaterialId(), model.getTextureId(),
+                  model.hasNormalMapping(), model.hasTexCoords());
+}
+
+/**
+ * @brief Counts the models of static groups per batch key, recursively.
+ *
+ * @param group The group to visit.
+ * @param counts The number of models per key.
+ */
+static void countStaticModels(const Group& group,
+                              std::map<BatchKey, int>& counts) {
+  if (!group.isStatic()) {
+    return;
+  }
+
+  for (const Model& model : group.getModels()) {
+    counts[makeBatchKey(model)]++;
+  }
+
+  for (const Group& child : group.getChildren()) {
+    countStaticModels(child, counts);
+  }
+}
+
+/**
+ * @brief Moves the models of static groups into batches, recursively.
+ *
+ * @param group The group to visit.
+ * @param parentWorld The world matrix of the parent group.
+ * @param counts The number of models per key, keys used once are skipped.
+ * @param batches The batches being built.
+ * @param batchIndexes The batch index of each key.
+ */
+static void collectStaticModels(Group& group, const glm::mat4& parentWorld,
+                                const std::map<BatchKey, int>& counts,
+                                std::vector<StaticBatch>& batches,
+                                std::map<BatchKey, int>& batchIndexes) {
+  if (!group.isStatic()) {
+    return;
+  }
+
+  glm::mat4 world =
+      parentWorld * applyTransformations(group.getTransformations(), 0.0f);
+
+  for (Model& model : group.getModels()) {
+    BatchKey key = makeBatchKey(model);
+    if (counts.at(key) < 2) {
+      // Nothing to merge with, batching would only duplicate the model
+      continue;
+    }
+
+    auto it = batchIndexes.find(key);
+    if (it == batchIndexes.end()) {
+      it = batchIndexes.emplace(key, static_cast<int>(batches.size())).first;
+      batches.emplace_back();
+
+      Model& mesh = batches.back().mesh;
+      mesh.setName("Static Batch " + std::to_string(it->second));
+      mesh.setMaterial(model.getMaterial());
+      if (model.hasTextureMapping()) {
+        mesh.shareTexture(model.getTextureId());
+      }
+    }
+
+    StaticBatch& batch = batches[it->second];
+    batch.mesh.appendTransformed(model, world);
+    batch.sources.push_back({&group, &model});
+    model.setBatch(it->second);
+  }
+
+  for (Group& child : group.getChildren()) {
+    collectStaticModels(child, world, counts, batches, batchIndexes);
+  }
+}
+
+/**
+ * @brief Merges the models of static groups into world-space batches.
+ *
+ * A group is static if neither it nor any of its ancestors has a time based
+ * transformation, so its models can be transformed once at load time. Models
+ * sharing material, texture and vertex attributes are merged into a single
+ * mesh, drawn with one call. The original models are marked with the index of
+ * their batch, which is used to skip them while batching is enabled and to map
+ * batches back to groups in the Inspector.
+ *
+ * @param root The root group of the scene.
+ * @param batches The list receiving the batches.
+ * @return The size and build time of the batches.
+ */
+StaticBatchReport buildStaticBatches(Group& root,
+                                     std::vector<StaticBatch>& batches) {
+  auto start = std::chrono::steady_clock::now();
+
+  batches.clear();
+  std::map<BatchKey, int> counts;
+  std::map<BatchKey, int> batchIndexes;
+  countStaticModels(root, counts);
+  collectStaticModels(root, glm::mat4(1.0f), counts, batches, batchIndexes);
+
+  StaticBatchReport report;
+  for (StaticBatch& batch : batches) {
+    batch.mesh.computeBounds();
+    batch.mesh.sendModelToGPU();
+    report.sourceCount += batch.sources.size();
+    report.gpuBytes += batch.mesh.getGPUSize();
+  }
+  report.batchCount = batches.size();
+
+  auto end = std::chrono::steady_clock::now();
+  report.buildMilliseconds =
+      std::chrono::duration<double, std::milli>(end - start).count();
+
+  logger.info("Built " + std::to_string(report.batchCount) +
+              " static batches from " + std::to_string(report.sourceCount) +
+              " models (" + std::to_string(report.gpuBytes / 1024) + " KB, " +
+              std::to_string(report.buildMilliseconds) + " ms).");
+
+  return report;
+}
+
+/**
+ * @brief Marks the models of static groups as drawn on their own again,
+ * recursively.
+ *
+ * @param group The group to visit.
+ */
+static void unmarkStaticModels(Group& group) {
+  if (!group.isStatic()) {
+    return;
+  }
+
+  for (Model& model : group.getModels()) {
+    model.setBatch(-1);
+  }
+
+  for (Group& child : group.getChildren()) {
+    unmarkStaticModels(child);
+  }
+}
+
+/**
+ * @brief Frees the batches built by buildStaticBatches.
+ *
+ * The meshes are returned to the GeometryHeap and the original models are
+ * drawn again.
+ *
+ * @param root The root group of the scene.
+ * @param batches The batches to free, emptied.
+ */
+void releaseStaticBatches(Group& root, std::vector<StaticBatch>& batches) {
+  for (StaticBatch& batch : batches) {
+    batch.mesh.releaseGPU();
+  }
+  batches.clear();
+  unmarkStaticModels(root);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "scene/Model.hpp"
+
+class Group;
+
+struct BatchSource {
+  const Group* group;
+  const Model* model;
+};
+
+struct StaticBatch {
+  Model mesh;
+  std::vector<BatchSource> sources;
+};
+
+struct StaticBatchReport {
+  size_t batchCount = 0;
+  size_t sourceCount = 0;
+  size_t gpuBytes = 0;
+  double buildMilliseconds = 0.0;
+};
+
+StaticBatchReport buildStaticBatches(Group& root,
+                                     std::vector<StaticBatch>& batches);
+void releaseStaticBatches(Group& root, std::vector<StaticBatch>& batches);
@@ -0,0 +1,82 @@
+#include "AnimationScheduler.hpp"
+
+#include "render/RenderQueue.hpp"
+
+/**
+ * @brief Starts a new frame of animation updates.
+ *
+ * @param enabled Whether hidden and sub-pixel groups may be updated at a
+ *                reduced rate. When disabled every group animates every frame.
+ */
+void AnimationScheduler::beginFrame(bool enabled) {
+  this->enabled = enabled;
+  frame++;
+}
+
+/**
+ * @brief Decides how a group is updated this frame.
+ *
+ * The world bounds of the group subtree from its last evaluation are grown by
+ * how far they could have moved since, using the speed measured between the
+ * last two evaluations. A subtree whose grown bounds are outside the frustum
+ * is skipped, one smaller than a pixel is drawn with its cached transforms.
+ * Both are still evaluated every few frames to keep their bounds and speed
+ * fresh. Anything that could be visible is evaluated exactly.
+ *
+ * @param state The animation state of the group.
+ * @param queue The render queue of the frame, holding the camera.
+ * @param time The current scene time.
+ * @return ANIMATE to evaluate the group, REPLAY to draw its cached transforms
+ *         or SKIP to leave it out of the frame.
+ */
+AnimationLod AnimationScheduler::classify(const AnimationState& state,
+                                          const RenderQueue& queue,
+                                          double time) const {
+  // The speed is only known after two evaluations
+  if (!enabled || state.evaluations < 2 || time < state.evaluatedAt) {
+    return ANIMATE;
+  }
+
+  uint32_t frames = frame - state.evaluatedFrame;
+  float elapsed = static_cast<float>(time - state.evaluatedAt);
+  float radius = state.radius + state.speed * elapsed * SPEED_MARGIN;
+
+  if (!queue.isVisible(state.center, radius)) {
+    return frames >= HIDDEN_INTERVAL ? ANIMATE : SKIP;
+  }
+
+  if (queue.getPixelRadius(state.center, radius) < SUB_PIXEL_RADIUS) {
+    return frames >= SUB_PIXEL_INTERVAL ? ANIMATE : REPLAY;
+  }
+
+  return ANIMATE;
+}
+
+/**
+ * @brief Stores the result of evaluating a group.
+ *
+ * @param state The animation state of the group.
+ * @param parentWorld The world matrix of the parent group.
+ * @param world The world matrix of the group.
+ * @param center The center of the world bounds of the group subtree.
+ * @param radius The radius of the world bounds of the group subtree.
+ * @param time The scene time of the evaluation.
+ */
+void AnimationScheduler::record(AnimationState& state,
+                                const glm::mat4& parentWorld,
+                                const glm::mat4& world,
+                                const glm::vec3& center, float radius,
+                                double time) const {
+  if (state.evaluations > 0 && time > state.evaluatedAt) {
+    state.speed = glm::length(center - state.center) /
+                  static_cast<float>(time - state.evaluatedAt);
+  }
+
+  state.parentWorld = parentWorld;
+  state.world = world;
+  state.center = center;
+  state.radius = radius;
+  state.evaluatedAt = time;
+  state.evaluatedFrame = frame;
+  state.evaluations++;
+}
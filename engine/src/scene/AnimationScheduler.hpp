@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class RenderQueue;
+
+enum AnimationLod { ANIMATE, REPLAY, SKIP };
+
+struct AnimationState {
+  glm::mat4 parentWorld = glm::mat4(1.0f);
+  glm::mat4 world = glm::mat4(1.0f);
+  glm::vec3 center = glm::vec3(0.0f);
+  float radius = 0.0f;
+  float speed = 0.0f;
+  double evaluatedAt = 0.0;
+  uint32_t evaluatedFrame = 0;
+  uint32_t evaluations = 0;
+};
+
+class AnimationScheduler {
+ private:
+  bool enabled = true;
+  uint32_t frame = 0;
+
+ public:
+  static constexpr uint32_t HIDDEN_INTERVAL = 16;
+  static constexpr uint32_t SUB_PIXEL_INTERVAL = 4;
+  static constexpr float SUB_PIXEL_RADIUS = 0.5f;
+  static constexpr float SPEED_MARGIN = 2.0f;
+
+  void beginFrame(bool enabled);
+  AnimationLod classify(const AnimationState& state, const RenderQueue& queue,
+                        double time) const;
+  void record(AnimationState& state, const glm::mat4& parentWorld,
+              const glm::mat4& world, const glm::vec3& center, float radius,
+              double time) const;
+};
@@ -1,40 +1,166 @@
 #include "Group.hpp"
 
 #include "debug/Logger.hpp"
+#include "math/Orbit.hpp"
 #include "math/Path.hpp"
 #include "math/Rotate.hpp"
 #include "math/Scale.hpp"
 #include "math/Translate.hpp"
+#include "render/DebugDraw.hpp"
 
 static debug::Logger logger;
 
 /**
- * @brief Renders all models and child groups within this group.
+ * @brief Grows a sphere so it also encloses another one.
  *
- * This function iterates through all models in the current group and calls
- * their render function. It then iterates through all child groups and calls
- * their render function recursively.
+ * @param center The center of the sphere to grow.
+ * @param radius The radius of the sphere to grow.
+ * @param otherCenter The center of the sphere to enclose.
+ * @param otherRadius The radius of the sphere to enclose.
  */
-void Group::render(float time, bool renderNormals, ViewMode viewMode) {
-  glPushMatrix();
+static void mergeSphere(glm::vec3& center, float& radius,
+                        const glm::vec3& otherCenter, float otherRadius) {
+  float distance = glm::length(otherCenter - center);
+  if (distance + otherRadius <= radius) {
+    return;
+  }
+  if (distance + radius <= otherRadius) {
+    center = otherCenter;
+    radius = otherRadius;
+    return;
+  }
 
-  applyTransformations(transformations, time);
+  float merged = (distance + radius + otherRadius) * 0.5f;
+  center += (otherCenter - center) * ((merged - radius) / distance);
+  radius = merged;
+}
 
-  for (Model& model : models) {
-    model.render(viewMode);
-    if (renderNormals) {
-      model.renderNormals(0.4f);
+/**
+ * @brief Extracts the draws of this group and its children into a queue.
+ *
+ * This function computes the world matrix of the group, emits one draw packet
+ * per model and recurses into the child groups. Nothing is drawn here, the
+ * queue is sorted and submitted once the whole scene graph is extracted.
+ *
+ * The scheduler may decide the subtree is off-screen or smaller than a pixel,
+ * in which case its animations are not evaluated this frame. While paths are
+ * drawn, a group with one anywhere in its subtree is always evaluated, since
+ * the curves can be visible when the models are not and skipping an ancestor
+ * would skip the descendants drawing them.
+ *
+ * @param queue The render queue receiving the draw packets.
+ * @param scheduler The scheduler deciding which groups are evaluated.
+ * @param parentWorld The world matrix of the parent group.
+ * @param time The current scene time.
+ * @param skipBatched Whether to skip models drawn by a static batch.
+ */
+void Group::collect(RenderQueue& queue, const AnimationScheduler& scheduler,
+                    const glm::mat4& parentWorld, double time,
+                    bool skipBatched) const {
+  queue.countGroup();
+
+  AnimationLod lod = subtreeRendersPaths && DebugDraw::isEnabled()
+                         ? ANIMATE
+                         : scheduler.classify(animation, queue, time);
+  if (lod != ANIMATE) {
+    queue.countAnimations(0, subtreeAnimations);
+    if (lod == REPLAY) {
+      replay(queue, skipBatched);
+    }
+    return;
+  }
+
+  if (rendersPaths && DebugDraw::isEnabled()) {
+    // Paths are drawn in the parent space
+    glm::mat4 modelView = queue.getView() * parentWorld;
+    for (const std::unique_ptr<Transformation>& transformation :
+         transformations) {
+      transformation->renderDebug(modelView);
+    }
+  }
+
+  glm::mat4 world = parentWorld * applyTransformations(transformations, time);
+  queue.countAnimations(animations, 0);
+
+  glm::vec3 center = glm::vec3(world[3]);
+  float radius = 0.0f;
+
+  if (!models.empty()) {
+    uint32_t transform = queue.pushTransform(world);
+    float scale = glm::max(glm::length(glm::vec3(world[0])),
+                           glm::max(glm::length(glm::vec3(world[1])),
+                                    glm::length(glm::vec3(world[2]))));
+    for (const Model& model : models) {
+      if (!skipBatched || !model.isBatched()) {
+        queue.push(model, transform);
+      }
+      mergeSphere(center, radius,
+                  glm::vec3(world * glm::vec4(model.getBoundsCenter(), 1.0f)),
+                  model.getBoundsRadius() * scale);
     }
   }
 
-  for (Group& group : children) {
-    group.render(time, renderNormals, viewMode);
+  for (const Group& group : children) {
+    group.collect(queue, scheduler, world, time, skipBatched);
+    mergeSphere(center, radius, group.animation.center,
+                group.animation.radius);
   }
 
-  glPopMatrix();
+  scheduler.record(animation, parentWorld, world, center, radius, time);
 }
 
+/**
+ * @brief Extracts the draws of this group and its children from the
+ * transforms of their last evaluation.
+ *
+ * @param queue The render queue receiving the draw packets.
+ * @param skipBatched Whether to skip models drawn by a static batch.
+ */
+void Group::replay(RenderQueue& queue, bool skipBatched) const {
+  queue.countGroup();
+
+  if (!models.empty()) {
+    uint32_t transform = queue.pushTransform(animation.world);
+    for (const Model& model : models) {
+      if (!skipBatched || !model.isBatched()) {
+        queue.push(model, transform);
+      }
+    }
+  }
+
+  for (const Group& group : children) {
+    if (group.animation.evaluations > 0) {
+      group.replay(queue, skipBatched);
+    }
+  }
+}
+
+/**
+ * @brief Checks whether the transformations of this group never change.
+ *
+ * @return true if none of the transformations depend on time.
+ */
+bool Group::isStatic() const {
+  for (const std::unique_ptr<Transformation>& transformation :
+       transformations) {
+    if (!transformation->isStatic()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Releases the GeometryHeap ranges of the group and its children and
+ * empties them.
+ */
 void Group::clear() {
+  for (Model& model : models) {
+    model.releaseGPU();
+  }
+  for (Group& child : children) {
+    child.clear();
+  }
   models.clear();
   children.clear();
   transformations.clear();
@@ -104,8 +230,18 @@ Group initializeGroupFromXML(tinyxml2::XMLElement* element) {
             render_path = transformation->BoolAttribute("render_path");
           }
 
-          group.addTransformation(
-              std::make_unique<Path>(duration, align, path, render_path));
+          if (render_path) {
+            group.setRendersPaths(true);
+          }
+
+          bool constant_speed = false;
+
+          if (transformation->Attribute("constant_speed") != nullptr) {
+            constant_speed = transformation->BoolAttribute("constant_speed");
+          }
+
+          group.addTransformation(std::make_unique<Path>(
+              duration, align, path, render_path, constant_speed));
         } else {
           // Normal translation
           float x = transformation->FloatAttribute("x");
@@ -128,8 +264,8 @@ Group initializeGroupFromXML(tinyxml2::XMLElement* element) {
         } else if (transformation->Attribute("angle") != nullptr) {
           angle = transformation->FloatAttribute("angle");
         } else {
-          logger.error("No angle or time attribute found for rotate (" +
-                       group.getName() + ").");
+          logger.errorf("No angle or time attribute found for rotate (%s).",
+                        group.getName().c_str());
         }
 
         float x = transformation->FloatAttribute("x");
@@ -138,6 +274,20 @@ Group initializeGroupFromXML(tinyxml2::XMLElement* element) {
 
         group.addTransformation(
             std::make_unique<Rotate>(angle, duration, x, y, z));
+      } else if (tag == "orbit") {
+        float radius = transformation->FloatAttribute("radius");
+        float eccentricity = transformation->FloatAttribute("eccentricity");
+        float inclination = transformation->FloatAttribute("inclination");
+        float period = transformation->FloatAttribute("period");
+        float phase = transformation->FloatAttribute("phase");
+        bool render_path = transformation->BoolAttribute("render_path");
+
+        if (render_path) {
+          group.setRendersPaths(true);
+        }
+
+        group.addTransformation(std::make_unique<Orbit>(
+            radius, eccentricity, inclination, period, phase, render_path));
       }
 
       transformation = transformation->NextSiblingElement();
@@ -223,26 +373,26 @@ Group initializeGroupFromXML(tinyxml2::XMLElement* element) {
           loadedModel.value().setMaterial(material);
         }
 
-        loadedModel.value().sendModelToGPU();
-
         // Maybe load texture data
 
         tinyxml2::XMLElement* textureElement =
             modelElement->FirstChildElement("texture");
-        if (textureElement != nullptr) {
+        if (textureElement != nullptr && Model::isGPUUploadEnabled()) {
           std::string texturePath = textureElement->Attribute("file");
-          std::optional<Texture> loadedTexture = loadTexture(texturePath);
-          if (loadedTexture.has_value()) {
-            loadedModel.value().sendTextureToGPU(loadedTexture.value());
-          } else {
-            logger.error("Failed to load texture from file: " + texturePath +
-                         ".");
+          if (!loadedModel.value().useCachedTexture(texturePath)) {
+            std::optional<Texture> loadedTexture = loadTexture(texturePath);
+            if (loadedTexture.has_value()) {
+              loadedModel.value().sendTextureToGPU(loadedTexture.value());
+            } else {
+              logger.errorf("Failed to load texture from file: %s.",
+                            texturePath.c_str());
+            }
           }
         }
 
         group.addModel(loadedModel.value());
       } else {
-        logger.error("Failed to load model from file: " + filename + ".");
+        logger.errorf("Failed to load model from file: %s.", filename.c_str());
       }
       modelElement = modelElement->NextSiblingElement("model");
     }
@@ -259,18 +409,19 @@ Group initializeGroupFromXML(tinyxml2::XMLElement* element) {
 }
 
 /*
- * @brief Applies a list of transformations to the current model matrix.
+ * @brief Composes a list of transformations into a model matrix.
  *
- * This function applies a list of transformations to the current model matrix
- * using OpenGL's glMultMatrixf function. The transformations are applied in
- * the order they are provided in the list.
+ * This function applies a list of transformations to an identity matrix. The
+ * transformations are applied in the order they are provided in the list.
  *
  * @param transformations A vector of unique pointers to Transformation objects
  *                        that represent the transformations to apply.
+ * @param time The current scene time.
+ * @return The composed model matrix.
  */
-void applyTransformations(
+glm::mat4 applyTransformations(
     const std::vector<std::unique_ptr<Transformation>>& transformations,
-    float time) {
+    double time) {
   glm::mat4 modelMatrix = glm::mat4(1.0f);
 
   for (const std::unique_ptr<Transformation>& transformation :
@@ -278,5 +429,5 @@ void applyTransformations(
     modelMatrix = transformation->apply(modelMatrix, time);
   }
 
-  glMultMatrixf(glm::value_ptr(modelMatrix));
+  return modelMatrix;
 }
\ No newline at end of file
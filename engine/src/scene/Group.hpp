@@ -1,4 +1,5 @@
 #pragma once
+#include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <tinyxml2.h>
 
@@ -6,9 +7,11 @@
 #include <memory>
 #include <vector>
 
+#include "AnimationScheduler.hpp"
 #include "Model.hpp"
 #include "engine/Settings.hpp"
 #include "math/Transformation.hpp"
+#include "render/RenderQueue.hpp"
 
 using std::unique_ptr;
 using std::vector;
@@ -19,6 +22,13 @@ class Group {
   vector<Group> children;
   vector<Model> models;
   vector<std::unique_ptr<Transformation>> transformations;
+  bool rendersPaths = false;
+  bool subtreeRendersPaths = false;
+  uint32_t animations = 0;
+  uint32_t subtreeAnimations = 0;
+  mutable AnimationState animation;
+
+  void replay(RenderQueue& queue, bool skipBatched) const;
 
  public:
   Group() = default;
@@ -27,20 +37,40 @@ class Group {
   Group(Group&&) = default;
   Group& operator=(Group&&) = default;
 
-  void render(float time, bool renderNormals, ViewMode viewMode);
+  void collect(RenderQueue& queue, const AnimationScheduler& scheduler,
+               const glm::mat4& parentWorld, double time,
+               bool skipBatched) const;
   void setName(string name) { this->name = name; }
   string getName() const { return name; }
-  void addChild(Group child) { children.push_back(std::move(child)); }
+  void addChild(Group child) {
+    subtreeAnimations += child.subtreeAnimations;
+    subtreeRendersPaths |= child.subtreeRendersPaths;
+    children.push_back(std::move(child));
+  }
   void addModel(Model model) { models.push_back(std::move(model)); }
   void addTransformation(std::unique_ptr<Transformation> transformation) {
+    if (!transformation->isStatic()) {
+      animations++;
+      subtreeAnimations++;
+    }
     transformations.push_back(std::move(transformation));
   }
+  void setRendersPaths(bool rendersPaths) {
+    this->rendersPaths = rendersPaths;
+    subtreeRendersPaths |= rendersPaths;
+  }
   void clear();
   const vector<Group>& getChildren() const { return children; }
   const vector<Model>& getModels() const { return models; }
+  vector<Group>& getChildren() { return children; }
+  vector<Model>& getModels() { return models; }
+  const vector<std::unique_ptr<Transformation>>& getTransformations() const {
+    return transformations;
+  }
+  bool isStatic() const;
 };
 
 Group initializeGroupFromXML(tinyxml2::XMLElement* element);
-void applyTransformations(
+glm::mat4 applyTransformations(
     const std::vector<std::unique_ptr<Transformation>>& transformations,
-    float time);
\ No newline at end of file
+    double time);
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <GL/glew.h>
 
+#include "render/StateCache.hpp"
+
 void Light::setPosition(const glm::vec3& pos) { position = pos; }
 
 void Light::setColor(const glm::vec3& col) { color = col; }
@@ -22,25 +24,36 @@ void Light::setDirection(const glm::vec3& dir) { direction = dir; }
 
 glm::vec3& Light::getDirection() { return direction; }
 
-void Light::render(int lightIndex) {
+void Light::render(int lightIndex) const {
   glm::vec4 dir = glm::vec4(direction, 0.0f);
   glm::vec4 pos = glm::vec4(position, 1.0f);
-
-  glEnable(GL_LIGHT0 + lightIndex);
-  glLightfv(GL_LIGHT0 + lightIndex, GL_DIFFUSE, &color.x);
-  glLightfv(GL_LIGHT0 + lightIndex, GL_SPECULAR, &color.x);
+  glm::vec4 col = glm::vec4(color, 1.0f);
+
+  StateCache::enable(GL_LIGHT0 + lightIndex);
+  StateCache::light(GL_LIGHT0 + lightIndex, GL_DIFFUSE, &col.x);
+  StateCache::light(GL_LIGHT0 + lightIndex, GL_SPECULAR, &col.x);
+
+  // Slots are shared by different lights, so reset what other types set.
+  // Ranged lights fade to about 5% of their color at their range.
+  StateCache::lightf(GL_LIGHT0 + lightIndex, GL_QUADRATIC_ATTENUATION,
+                     type != DIRECTIONAL && range > 0.0f
+                         ? 20.0f / (range * range)
+                         : 0.0f);
+  if (type != SPOTLIGHT) {
+    StateCache::lightf(GL_LIGHT0 + lightIndex, GL_SPOT_CUTOFF, 180.0f);
+  }
 
   switch (type) {
     case DIRECTIONAL:
-      glLightfv(GL_LIGHT0 + lightIndex, GL_POSITION, &dir.x);
+      StateCache::light(GL_LIGHT0 + lightIndex, GL_POSITION, &dir.x);
       break;
     case POINT:
-      glLightfv(GL_LIGHT0 + lightIndex, GL_POSITION, &pos.x);
+      StateCache::light(GL_LIGHT0 + lightIndex, GL_POSITION, &pos.x);
       break;
     case SPOTLIGHT:
-      glLightfv(GL_LIGHT0 + lightIndex, GL_POSITION, &pos.x);
-      glLightfv(GL_LIGHT0 + lightIndex, GL_SPOT_DIRECTION, &dir.x);
-      glLightf(GL_LIGHT0 + lightIndex, GL_SPOT_CUTOFF, cutoff);
+      StateCache::light(GL_LIGHT0 + lightIndex, GL_POSITION, &pos.x);
+      StateCache::light(GL_LIGHT0 + lightIndex, GL_SPOT_DIRECTION, &dir.x);
+      StateCache::lightf(GL_LIGHT0 + lightIndex, GL_SPOT_CUTOFF, cutoff);
       break;
     default:
       break;
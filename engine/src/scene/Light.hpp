@@ -9,6 +9,7 @@ class Light {
   glm::vec3 direction;
   glm::vec3 color;
   float cutoff;
+  float range = 0.0f;
   LightType type;
 
  public:
@@ -17,11 +18,13 @@ class Light {
   void setCutoff(float cutoff);
   void setType(LightType t);
   void setDirection(const glm::vec3& dir);
-  void render(int lightIndex);
+  void setRange(float range) { this->range = range; }
+  void render(int lightIndex) const;
 
   glm::vec3& getDirection();
   glm::vec3& getPosition();
   glm::vec3& getColor();
   float getCutoff();
+  float getRange() const { return range; }
   LightType getType();
 };
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "MemoryReport.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_set>
+
+#include "Scene.hpp"
+#include "debug/Json.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
+
+static debug::Logger logger;
+
+static bool largerFirst(const AssetMemory& a, const AssetMemory& b) {
+  return a.cpuBytes + a.gpuBytes > b.cpuBytes + b.gpuBytes;
+}
+
+/**
+ * @brief Accounts the models and textures of a group and its children.
+ *
+ * A texture shared by several models of a group is counted once for the
+ * group, and listed once for the whole report with the first group using it.
+ *
+ * @param group The group.
+ * @param path The names of the group and its parents.
+ * @param seen The textures already listed.
+ * @param cpuBytes Increased by the CPU memory of the subtree.
+ * @param gpuBytes Increased by the GPU memory of the subtree.
+ */
+void MemoryReport::addGroup(const Group& group, const std::string& path,
+                            std::unordered_set<uint32_t>& seen,
+                            size_t& cpuBytes, size_t& gpuBytes) {
+  size_t index = groups.size();
+  groups.push_back({path, 0, 0, 0, 0});
+
+  std::unordered_set<uint32_t> groupTextures;
+  for (const Model& model : group.getModels()) {
+    ModelMemory memory = model.getMemoryUsage();
+    models.push_back(
+        {model.getName(), path, memory.cpuBytes, memory.getGPUBytes()});
+    modelCpuBytes += memory.cpuBytes;
+    modelGpuBytes += memory.getGPUBytes();
+    groups[index].cpuBytes += memory.cpuBytes;
+    groups[index].gpuBytes += memory.getGPUBytes();
+
+    uint32_t texture = model.getTextureId();
+    if (texture != 0 && groupTextures.insert(texture).second) {
+      size_t size = getTextureGPUSize(texture);
+      groups[index].gpuBytes += size;
+      if (seen.insert(texture).second) {
+        textures.push_back({getTextureName(texture), path, 0, size});
+        textureGpuBytes += size;
+      }
+    }
+  }
+
+  size_t subtreeCpuBytes = groups[index].cpuBytes;
+  size_t subtreeGpuBytes = groups[index].gpuBytes;
+  for (const Group& child : group.getChildren()) {
+    addGroup(child, path + "/" + child.getName(), seen, subtreeCpuBytes,
+             subtreeGpuBytes);
+  }
+  groups[index].subtreeCpuBytes = subtreeCpuBytes;
+  groups[index].subtreeGpuBytes = subtreeGpuBytes;
+  cpuBytes += subtreeCpuBytes;
+  gpuBytes += subtreeGpuBytes;
+}
+
+/**
+ * @brief Accounts the memory of every model, texture and group of a scene.
+ *
+ * Static batch meshes are reported under a "Static Batches" group, since
+ * they do not belong to any group of the scene graph.
+ *
+ * @param scene The scene.
+ */
+void MemoryReport::build(const Scene& scene) {
+  *this = MemoryReport();
+
+  std::unordered_set<uint32_t> seen;
+  size_t cpuBytes = 0;
+  size_t gpuBytes = 0;
+  addGroup(scene.getRoot(), "World", seen, cpuBytes, gpuBytes);
+
+  if (!scene.getStaticBatches().empty()) {
+    GroupMemory batches = {"Static Batches", 0, 0, 0, 0};
+    for (const StaticBatch& batch : scene.getStaticBatches()) {
+      ModelMemory memory = batch.mesh.getMemoryUsage();
+      models.push_back({batch.mesh.getName(), batches.path, memory.cpuBytes,
+                        memory.getGPUBytes()});
+      modelCpuBytes += memory.cpuBytes;
+      modelGpuBytes += memory.getGPUBytes();
+      batches.cpuBytes += memory.cpuBytes;
+      batches.gpuBytes += memory.getGPUBytes();
+    }
+    batches.subtreeCpuBytes = batches.cpuBytes;
+    batches.subtreeGpuBytes = batches.gpuBytes;
+    groups.push_back(batches);
+  }
+
+  std::sort(models.begin(), models.end(), largerFirst);
+  std::sort(textures.begin(), textures.end(), largerFirst);
+  peakResidentBytes = debug::getPeakResidentBytes();
+}
+
+static void writeAssets(FILE* file, const char* key,
+                        const std::vector<AssetMemory>& assets) {
+  std::fprintf(file, "  \"%s\": [\n", key);
+  for (size_t i = 0; i < assets.size(); i++) {
+    const AssetMemory& asset = assets[i];
+    std::fprintf(file,
+                 "    {\"name\": \"%s\", \"group\": \"%s\", "
+                 "\"cpu_bytes\": %zu, \"gpu_bytes\": %zu}%s\n",
+                 debug::escapeJson(asset.name).c_str(),
+                 debug::escapeJson(asset.group).c_str(), asset.cpuBytes,
+                 asset.gpuBytes, i + 1 < assets.size() ? "," : "");
+  }
+  std::fprintf(file, "  ],\n");
+}
+
+/**
+ * @brief Writes the report as JSON, with assets sorted by size.
+ *
+ * @param path The path of the JSON file.
+ * @return true if the file was written.
+ */
+bool MemoryReport::writeJson(const std::string& path) const {
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    logger.error("Failed to open " + path + " for writing.");
+    return false;
+  }
+
+  std::fprintf(file, "{\n");
+  std::fprintf(file, "  \"totals\": {\n");
+  std::fprintf(file, "    \"model_cpu_bytes\": %zu,\n", modelCpuBytes);
+  std::fprintf(file, "    \"model_gpu_bytes\": %zu,\n", modelGpuBytes);
+  std::fprintf(file, "    \"texture_gpu_bytes\": %zu,\n", textureGpuBytes);
+  std::fprintf(file, "    \"peak_resident_bytes\": %zu\n", peakResidentBytes);
+  std::fprintf(file, "  },\n");
+  writeAssets(file, "models", models);
+  writeAssets(file, "textures", textures);
+  std::fprintf(file, "  \"groups\": [\n");
+  for (size_t i = 0; i < groups.size(); i++) {
+    const GroupMemory& group = groups[i];
+    std::fprintf(file,
+                 "    {\"path\": \"%s\", \"cpu_bytes\": %zu, "
+                 "\"gpu_bytes\": %zu, \"subtree_cpu_bytes\": %zu, "
+                 "\"subtree_gpu_bytes\": %zu}%s\n",
+                 debug::escapeJson(group.path).c_str(), group.cpuBytes,
+                 group.gpuBytes, group.subtreeCpuBytes, group.subtreeGpuBytes,
+                 i + 1 < groups.size() ? "," : "");
+  }
+  std::fprintf(file, "  ]\n");
+  std::fprintf(file, "}\n");
+  std::fclose(file);
+
+  logger.info("Wrote memory report to " + path + ".");
+  return true;
+}
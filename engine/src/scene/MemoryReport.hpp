@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class Scene;
+class Group;
+
+struct AssetMemory {
+  std::string name;
+  std::string group;
+  size_t cpuBytes;
+  size_t gpuBytes;
+};
+
+struct GroupMemory {
+  std::string path;
+  size_t cpuBytes;
+  size_t gpuBytes;
+  size_t subtreeCpuBytes;
+  size_t subtreeGpuBytes;
+};
+
+class MemoryReport {
+ private:
+  std::vector<AssetMemory> models;
+  std::vector<AssetMemory> textures;
+  std::vector<GroupMemory> groups;
+  size_t modelCpuBytes = 0;
+  size_t modelGpuBytes = 0;
+  size_t textureGpuBytes = 0;
+  size_t peakResidentBytes = 0;
+
+  void addGroup(const Group& group, const std::string& path,
+                std::unordered_set<uint32_t>& seen, size_t& cpuBytes,
+                size_t& gpuBytes);
+
+ public:
+  void build(const Scene& scene);
+  bool writeJson(const std::string& path) const;
+  const std::vector<AssetMemory>& getModels() const { return models; }
+  const std::vector<AssetMemory>& getTextures() const { return textures; }
+  const std::vector<GroupMemory>& getGroups() const { return groups; }
+  size_t getModelCpuBytes() const { return modelCpuBytes; }
+  size_t getModelGpuBytes() const { return modelGpuBytes; }
+  size_t getTextureGpuBytes() const { return textureGpuBytes; }
+  size_t getPeakResidentBytes() const { return peakResidentBytes; }
+  bool isEmpty() const { return groups.empty(); }
+};
@@ -3,21 +3,47 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <optional>
 #include <sstream>
+#include <unordered_map>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include "Settings.hpp"
 #include "debug/Logger.hpp"
+#include "render/DebugDraw.hpp"
+#include "render/GeometryHeap.hpp"
+#include "render/StateCache.hpp"
 
 using std::optional;
 
 static debug::Logger logger;
 
+// GL textures already uploaded for the current context, by file path
+static std::unordered_map<std::string, uint32_t> textureCache;
+
+struct TextureInfo {
+  std::string name;
+  uint32_t width;
+  uint32_t height;
+};
+
+// Uploaded textures, by GL texture, for memory accounting
+static std::unordered_map<uint32_t, TextureInfo> textureInfos;
+
+// Interned materials, indexed by material id
+static vector<Material> materials = {Material()};
+
+// Interned GL textures, indexed by texture id, id 0 is untextured
+static vector<uint32_t> textures = {0};
+
+// Headless simulations load scenes without a GL context
+bool Model::uploadEnabled = true;
+
 /**
  * @brief Parses the an index from a given string_view.
  *
@@ -75,7 +101,7 @@ optional<Model> loadModel(const string& filename) {
 
   std::ifstream file(filename);
   if (!file.is_open()) {
-    logger.error("Failed to open file: " + filename);
+    logger.errorf("Failed to open file: %s", filename.c_str());
     return {};
   }
 
@@ -177,6 +203,7 @@ optional<Model> loadModel(const string& filename) {
   model.setName(filename);
   file.close();
 
+  model.computeBounds();
   model.sendModelToGPU();
 
   return model;
@@ -201,7 +228,7 @@ optional<Texture> loadTexture(const std::string& file_path) {
 
 void Model::sendTextureToGPU(Texture& texture) {
   glGenTextures(1, &textureBuffer);
-  glBindTexture(GL_TEXTURE_2D, textureBuffer);
+  StateCache::bindTexture(GL_TEXTURE_2D, textureBuffer);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -210,155 +237,337 @@ void Model::sendTextureToGPU(Texture& texture) {
                texture.GetHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
                texture.GetTextureData().get());
   glGenerateMipmap(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  StateCache::bindTexture(GL_TEXTURE_2D, 0);
   hasTexture = true;
+  textureId = internTexture(textureBuffer);
+  textureCache[texture.GetName()] = textureBuffer;
+  textureInfos[textureBuffer] = {texture.GetName(), texture.GetWidth(),
+                                 texture.GetHeight()};
 }
 
 /**
- * @brief Sends the model data to the GPU.
+ * @brief Reuses a texture already uploaded from the same file.
+ *
+ * Models sharing a texture file also share the GL texture, which avoids
+ * decoding the image again and lets draws with the same texture be grouped.
  *
- * This function generates OpenGL buffers for the vertex, normal, texture
- * coordinate, and index data of the model and uploads the data to the GPU.
+ * @param texture_name The path of the texture file.
+ * @return true if the texture was found in the cache.
  */
-void Model::sendModelToGPU() {
-  // Create and bind vertex buffer
-  glGenBuffers(1, &vertexBuffer);
-  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vec3), vertices.data(),
-               GL_STATIC_DRAW);
-
-  // Create and bind normal buffer if we have normals
-  if (!normals.empty()) {
-    hasNormals = true;
-    glGenBuffers(1, &normalBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(vec3), normals.data(),
-                 GL_STATIC_DRAW);
+bool Model::useCachedTexture(const std::string& texture_name) {
+  auto it = textureCache.find(texture_name);
+  if (it == textureCache.end()) {
+    return false;
   }
 
-  // Create and bind texture coordinate buffer if we have texture coordinates
-  if (!texCoords.empty()) {
-    glGenBuffers(1, &texCoordBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
-    glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(vec2),
-                 texCoords.data(), GL_STATIC_DRAW);
-  }
+  shareTexture(it->second);
+  return true;
+}
 
-  // Create and bind index buffer
-  glGenBuffers(1, &indexBuffer);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexes.size() * sizeof(uint32_t),
-               indexes.data(), GL_STATIC_DRAW);
+void Model::shareTexture(uint32_t texture) {
+  textureBuffer = texture;
+  hasTexture = true;
+  textureId = internTexture(texture);
 }
 
-void Model::addVertex(vec3 vertex) { vertices.push_back(vertex); }
+/**
+ * @brief Forgets all cached textures.
+ *
+ * Must be called when the GL context owning the textures is destroyed.
+ */
+void clearTextureCache() {
+  textureCache.clear();
+  textureInfos.clear();
+  textures.assign(1, 0);
+}
 
-void Model::addNormal(vec3 normal) { normals.push_back(normal); }
+/**
+ * @brief Returns the GPU size of an uploaded texture with its mipmaps.
+ *
+ * @param texture The GL texture.
+ * @return The size in bytes, 0 if the texture was not uploaded by a model.
+ */
+size_t getTextureGPUSize(uint32_t texture) {
+  auto it = textureInfos.find(texture);
+  if (it == textureInfos.end()) {
+    return 0;
+  }
 
-void Model::addTexCoord(vec2 texCoord) { texCoords.push_back(texCoord); }
+  // Textures are stored as RGBA8 with a full mipmap chain
+  size_t size = 0;
+  uint32_t width = it->second.width;
+  uint32_t height = it->second.height;
+  while (true) {
+    size += static_cast<size_t>(width) * height * 4;
+    if (width == 1 && height == 1) {
+      break;
+    }
+    width = std::max(width / 2, 1u);
+    height = std::max(height / 2, 1u);
+  }
+  return size;
+}
 
-void Model::addIndex(uint32_t index) { indexes.push_back(index); }
+/**
+ * @brief Returns the file an uploaded texture was loaded from.
+ *
+ * @param texture The GL texture.
+ * @return The path of the file, empty if it is unknown.
+ */
+const std::string& getTextureName(uint32_t texture) {
+  static const std::string UNKNOWN;
+  auto it = textureInfos.find(texture);
+  return it == textureInfos.end() ? UNKNOWN : it->second.name;
+}
 
 /**
- * @brief Renders the normals of the model as lines.
+ * @brief Appends the geometry of another model, transformed to world space.
  *
- * This function visualizes the normals of the model by drawing lines from each
- * vertex in the direction of its normal. This is useful for debugging to ensure
- * normals are loaded and calculated correctly.
+ * Vertices are transformed by the world matrix and normals by its inverse
+ * transpose. Attributes are matched to vertices by index when they are
+ * interleaved, so those of a model without normals or texture coordinates
+ * are padded with zeros before the next model appends its own.
  *
- * @param scale The length of the normal lines.
+ * @param model The model to append.
+ * @param world The world matrix of the model.
  */
-void Model::renderNormals(float scale) {
-  if (!hasNormals || normals.empty() || vertices.empty()) {
-    return;
+void Model::appendTransformed(const Model& model, const glm::mat4& world) {
+  glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(world));
+  size_t baseVertex = vertices.size();
+
+  for (const vec3& vertex : model.vertices) {
+    vertices.push_back(vec3(world * vec4(vertex, 1.0f)));
   }
 
-  if (normals.size() != vertices.size()) {
-    return;
+  if (!model.normals.empty()) {
+    normals.resize(baseVertex, vec3(0.0f));
+    for (const vec3& normal : model.normals) {
+      normals.push_back(glm::normalize(normalMatrix * normal));
+    }
+  }
+
+  if (!model.texCoords.empty()) {
+    texCoords.resize(baseVertex, vec2(0.0f));
+    texCoords.insert(texCoords.end(), model.texCoords.begin(),
+                     model.texCoords.end());
+  }
+
+  for (uint32_t index : model.indexes) {
+    indexes.push_back(static_cast<uint32_t>(baseVertex) + index);
   }
+}
 
-  GLboolean lighting_enabled = glIsEnabled(GL_LIGHTING);
-  GLboolean texture_enabled = glIsEnabled(GL_TEXTURE_2D);
+/**
+ * @brief Sends the model data to the GPU.
+ *
+ * This function interleaves the vertex, normal and texture coordinate data of
+ * the model and uploads it, along with the indices, into the shared
+ * GeometryHeap. Missing attributes are left zeroed. Uploading again replaces
+ * the previous upload. Nothing is uploaded when GPU uploads are disabled, as
+ * in headless simulations.
+ */
+void Model::sendModelToGPU() {
+  releaseGPU();
 
-  glDisable(GL_LIGHTING);
-  glDisable(GL_TEXTURE_2D);
+  hasNormals = !normals.empty();
 
-  glColor3f(1.0f, 0.0f, 0.0f);
+  if (!uploadEnabled) {
+    return;
+  }
 
-  glBegin(GL_LINES);
+  // A zero scale is never requested, the normal lines are rebuilt on next use
+  normalLinesScale = 0.0f;
 
+  vector<HeapVertex> interleaved(vertices.size());
   for (size_t i = 0; i < vertices.size(); i++) {
-    const vec3& vertex = vertices[i];
-    const vec3& normal = normals[i];
+    HeapVertex& vertex = interleaved[i];
+    vertex.position = vertices[i];
+    vertex.normal = i < normals.size() ? normals[i] : vec3(0.0f);
+    vertex.texCoord = i < texCoords.size() ? texCoords[i] : vec2(0.0f);
+  }
 
-    glVertex3f(vertex.x, vertex.y, vertex.z);
+  geometry = GeometryHeap::upload(interleaved, indexes);
+}
 
-    glVertex3f(vertex.x + normal.x * scale, vertex.y + normal.y * scale,
-               vertex.z + normal.z * scale);
+/**
+ * @brief Frees the GPU ranges of the model, if it was uploaded.
+ */
+void Model::releaseGPU() {
+  if (geometry != GeometryHeap::INVALID_HANDLE) {
+    GeometryHeap::release(geometry);
+    geometry = GeometryHeap::INVALID_HANDLE;
   }
-  glEnd();
+}
 
-  // Reset color
-  glColor3f(1.0f, 1.0f, 1.0f);
+/**
+ * @brief Returns the size of the model data in the GeometryHeap.
+ *
+ * @return The size in bytes of the vertices and indices of the model.
+ */
+size_t Model::getGPUSize() const {
+  return vertices.size() * sizeof(HeapVertex) +
+         indexes.size() * sizeof(uint32_t);
+}
 
-  // Restore previous OpenGL state
-  if (texture_enabled) {
-    glEnable(GL_TEXTURE_2D);
+/**
+ * @brief Returns the memory used by the model, excluding its texture, which
+ * may be shared.
+ *
+ * CPU sizes are the capacities of the model vectors. GPU sizes are those of
+ * its GeometryHeap ranges and of its cached normal lines.
+ *
+ * @return The memory of the model, by buffer.
+ */
+ModelMemory Model::getMemoryUsage() const {
+  ModelMemory memory;
+  memory.cpuBytes = sizeof(Model) + name.capacity() +
+                    vertices.capacity() * sizeof(vec3) +
+                    normals.capacity() * sizeof(vec3) +
+                    texCoords.capacity() * sizeof(vec2) +
+                    indexes.capacity() * sizeof(uint32_t);
+
+  if (geometry != GeometryHeap::INVALID_HANDLE) {
+    const GeometryAllocation& allocation = GeometryHeap::get(geometry);
+    memory.vertexBufferBytes = allocation.vertexCount * sizeof(HeapVertex);
+    memory.indexBufferBytes = allocation.indexCount * sizeof(uint32_t);
   }
-  if (lighting_enabled) {
-    glEnable(GL_LIGHTING);
+  memory.debugBufferBytes = DebugDraw::getLinesSize(normalLines);
+  return memory;
+}
+
+void Model::addVertex(vec3 vertex) { vertices.push_back(vertex); }
+
+void Model::addNormal(vec3 normal) { normals.push_back(normal); }
+
+void Model::addTexCoord(vec2 texCoord) { texCoords.push_back(texCoord); }
+
+void Model::addIndex(uint32_t index) { indexes.push_back(index); }
+
+/**
+ * @brief Returns a stable id for a material.
+ *
+ * Identical materials share the same id, which lets the render queue sort and
+ * compare materials without looking at their contents. Id 0 is always the
+ * default material.
+ *
+ * @param material The material to intern.
+ * @return The id of the material.
+ */
+uint16_t internMaterial(const Material& material) {
+  for (size_t i = 0; i < materials.size(); i++) {
+    if (materials[i] == material) {
+      return static_cast<uint16_t>(i);
+    }
   }
+
+  materials.push_back(material);
+  return static_cast<uint16_t>(materials.size() - 1);
 }
 
+const vector<Material>& getMaterials() { return materials; }
+
 /**
- * @brief Renders the model using OpenGL.
+ * @brief Returns a small dense id for a GL texture.
  *
- * This function binds the vertex, normal, and texture coordinate buffers and
- * issues a draw call to render the model.
+ * GL texture names can be any 32-bit value, the render queue sorts by these
+ * ids instead so they fit its 16-bit texture field. Id 0 is no texture.
+ *
+ * @param texture The GL texture to intern.
+ * @return The id of the texture.
  */
-void Model::render(ViewMode viewMode) {
-  glMaterialfv(GL_FRONT, GL_AMBIENT, &material.ambient.x);
-  glMaterialfv(GL_FRONT, GL_DIFFUSE, &material.diffuse.x);
-  glMaterialfv(GL_FRONT, GL_SPECULAR, &material.specular.x);
-  glMaterialfv(GL_FRONT, GL_EMISSION, &material.emission.x);
-  glMaterialf(GL_FRONT, GL_SHININESS, material.shininess);
-
-  // Enable client states
-  glEnableClientState(GL_VERTEX_ARRAY);
-
-  // Bind vertex buffer
-  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-  glVertexPointer(3, GL_FLOAT, 0, 0);
-
-  // If we have normals, bind them
-  if (hasNormals) {
-    glEnableClientState(GL_NORMAL_ARRAY);
-    glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-    glNormalPointer(GL_FLOAT, 0, 0);
+uint16_t internTexture(uint32_t texture) {
+  for (size_t i = 0; i < textures.size(); i++) {
+    if (textures[i] == texture) {
+      return static_cast<uint16_t>(i);
+    }
   }
 
-  // If we have a texture, bind it
-  if (hasTexture && !texCoords.empty() && viewMode != WIREFRAME) {
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
-    glTexCoordPointer(2, GL_FLOAT, 0, 0);
+  textures.push_back(texture);
+  return static_cast<uint16_t>(textures.size() - 1);
+}
+
+/**
+ * @brief Computes the local-space bounding sphere of the model.
+ *
+ * The sphere is centered on the axis-aligned bounding box of the vertices and
+ * is used to estimate the depth of the model when sorting draws.
+ */
+void Model::computeBounds() {
+  if (vertices.empty()) {
+    boundsCenter = vec3(0.0f);
+    boundsRadius = 0.0f;
+    return;
+  }
 
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureBuffer);
+  vec3 min = vertices[0];
+  vec3 max = vertices[0];
+  for (const vec3& vertex : vertices) {
+    min = glm::min(min, vertex);
+    max = glm::max(max, vertex);
   }
 
-  // Bind index buffer and draw
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-  glDrawElements(GL_TRIANGLES, indexes.size(), GL_UNSIGNED_INT, 0);
+  boundsCenter = (min + max) * 0.5f;
+  boundsRadius = 0.0f;
+  for (const vec3& vertex : vertices) {
+    boundsRadius = std::max(boundsRadius, glm::length(vertex - boundsCenter));
+  }
+}
 
-  glDisableClientState(GL_VERTEX_ARRAY);
+/**
+ * @brief Renders the normals of the model as lines.
+ *
+ * This function visualizes the normals of the model by drawing lines from each
+ * vertex in the direction of its normal. This is useful for debugging to ensure
+ * normals are loaded and calculated correctly. The lines are uploaded once and
+ * only rebuilt when the scale changes, then queued on the debug-draw system.
+ *
+ * @param modelView The model view matrix of the model.
+ * @param scale The length of the normal lines.
+ */
+void Model::renderNormals(const glm::mat4& modelView, float scale) const {
+  if (!hasNormals || normals.empty() || vertices.empty()) {
+    return;
+  }
 
-  if (hasNormals) {
-    glDisableClientState(GL_NORMAL_ARRAY);
+  if (normals.size() != vertices.size()) {
+    return;
   }
 
-  if (hasTexture && !texCoords.empty()) {
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-    glDisable(GL_TEXTURE_2D);
+  if (normalLines == DebugDraw::INVALID_LINES || normalLinesScale != scale) {
+    vector<vec3> lines;
+    lines.reserve(vertices.size() * 2);
+    for (size_t i = 0; i < vertices.size(); i++) {
+      lines.push_back(vertices[i]);
+      lines.push_back(vertices[i] + normals[i] * scale);
+    }
+
+    if (normalLines == DebugDraw::INVALID_LINES) {
+      normalLines = DebugDraw::createLines(lines, GL_LINES);
+    } else {
+      DebugDraw::updateLines(normalLines, lines);
+    }
+    normalLinesScale = scale;
   }
-}
\ No newline at end of file
+
+  DebugDraw::drawLines(normalLines, modelView, vec3(1.0f, 0.0f, 0.0f));
+}
+
+/**
+ * @brief Applies the material of the model to the front faces.
+ */
+void Model::applyMaterial() const {
+  StateCache::material(GL_FRONT, GL_AMBIENT, &material.ambient.x);
+  StateCache::material(GL_FRONT, GL_DIFFUSE, &material.diffuse.x);
+  StateCache::material(GL_FRONT, GL_SPECULAR, &material.specular.x);
+  StateCache::material(GL_FRONT, GL_EMISSION, &material.emission.x);
+  StateCache::materialf(GL_FRONT, GL_SHININESS, material.shininess);
+}
+
+/**
+ * @brief Draws the model using OpenGL.
+ *
+ * This function issues a draw call for the range of the model in the
+ * GeometryHeap. The heap, material, texture and client array state is expected
+ * to be set by the caller, see RenderQueue::submit.
+ */
+void Model::draw() const { GeometryHeap::draw(geometry); }
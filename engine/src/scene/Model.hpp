@@ -1,9 +1,11 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "engine/Settings.hpp"
@@ -21,8 +23,29 @@ struct Material {
   vec3 specular = vec4(0.0f, 0.0f, 0.0f, 1.0f);
   vec3 emission = vec4(0.0f, 0.0f, 0.0f, 1.0f);
   float shininess = 0.0f;
+
+  bool operator==(const Material &other) const {
+    return ambient == other.ambient && diffuse == other.diffuse &&
+           specular == other.specular && emission == other.emission &&
+           shininess == other.shininess;
+  }
+};
+
+struct ModelMemory {
+  size_t cpuBytes = 0;
+  size_t vertexBufferBytes = 0;
+  size_t indexBufferBytes = 0;
+  size_t debugBufferBytes = 0;
+
+  size_t getGPUBytes() const {
+    return vertexBufferBytes + indexBufferBytes + debugBufferBytes;
+  }
 };
 
+uint16_t internMaterial(const Material &material);
+const vector<Material> &getMaterials();
+uint16_t internTexture(uint32_t texture);
+
 class Texture {
  private:
   std::string texture_name;
@@ -44,38 +67,86 @@ class Texture {
 
 class Model {
  private:
+  static bool uploadEnabled;
+
   string name;
   vector<vec3> vertices;
   vector<vec3> normals;
   vector<vec2> texCoords;
   vector<uint32_t> indexes;
-  uint32_t vertexBuffer;
-  uint32_t normalBuffer;
-  uint32_t texCoordBuffer;
-  uint32_t indexBuffer;
+  uint32_t geometry;
   uint32_t textureBuffer;
   bool hasTexture;
   bool hasNormals;
   Material material;
+  uint16_t materialId;
+  uint16_t textureId;
+  vec3 boundsCenter;
+  float boundsRadius;
+  int batch;
+  mutable uint32_t normalLines;
+  mutable float normalLinesScale;
 
  public:
-  Model() : hasTexture(false), hasNormals(false){};
+  Model()
+      : geometry(UINT32_MAX),
+        hasTexture(false),
+        hasNormals(false),
+        materialId(0),
+        textureId(0),
+        boundsCenter(0.0f),
+        boundsRadius(0.0f),
+        batch(-1),
+        normalLines(UINT32_MAX),
+        normalLinesScale(0.0f){};
   void addVertex(vec3 vertex);
   void addNormal(vec3 normal);
   void addTexCoord(vec2 texCoord);
   void addIndex(uint32_t index);
   void setName(const string &name) { this->name = name; }
-  void render(ViewMode viewMode);
-  void renderNormals(float scale);
-  void setMaterial(const Material &mat) { material = mat; }
+  void draw() const;
+  void applyMaterial() const;
+  void renderNormals(const glm::mat4 &modelView, float scale) const;
+  void setMaterial(const Material &mat) {
+    material = mat;
+    materialId = internMaterial(mat);
+  }
   Material getMaterial() const { return material; }
+  uint16_t getMaterialId() const { return materialId; }
+  uint32_t getGeometry() const { return geometry; }
+  uint32_t getTextureId() const { return hasTexture ? textureBuffer : 0; }
+  // Dense id of the texture for sorting, 0 if untextured
+  uint16_t getTextureSortId() const { return hasTexture ? textureId : 0; }
+  bool usesTexture(ViewMode viewMode) const {
+    return hasTexture && !texCoords.empty() && viewMode != WIREFRAME;
+  }
+  void computeBounds();
+  const vec3 &getBoundsCenter() const { return boundsCenter; }
+  float getBoundsRadius() const { return boundsRadius; }
   const string &getName() const { return name; }
   void sendTextureToGPU(Texture &texture);
+  bool useCachedTexture(const std::string &texture_name);
+  void shareTexture(uint32_t texture);
   void sendModelToGPU();
+  static void setGPUUploadEnabled(bool enabled) { uploadEnabled = enabled; }
+  static bool isGPUUploadEnabled() { return uploadEnabled; }
+  void releaseGPU();
+  void appendTransformed(const Model &model, const glm::mat4 &world);
   bool hasTextureMapping() const { return hasTexture; }
   bool hasNormalMapping() const { return hasNormals; }
+  bool hasTexCoords() const { return !texCoords.empty(); }
   size_t getVertexCount() const { return vertices.size(); }
+  size_t getIndexCount() const { return indexes.size(); }
+  size_t getGPUSize() const;
+  ModelMemory getMemoryUsage() const;
+  void setBatch(int batch) { this->batch = batch; }
+  int getBatch() const { return batch; }
+  bool isBatched() const { return batch >= 0; }
 };
 
+size_t parseIndex(std::string_view string, int index);
 optional<Model> loadModel(const string &filename);
-optional<Texture> loadTexture(const std::string &file_path);
\ No newline at end of file
+optional<Texture> loadTexture(const std::string &file_path);
+void clearTextureCache();
+size_t getTextureGPUSize(uint32_t texture);
+const std::string &getTextureName(uint32_t texture);
\ No newline at end of file
@@ -1,7 +1,56 @@
 #include "Scene.hpp"
 
-void Scene::render(ViewMode viewMode, bool showNormals) {
-  root.render(time, showNormals, viewMode);
+#include "render/GeometryHeap.hpp"
+
+void Scene::collect(RenderQueue& queue, const AnimationScheduler& scheduler,
+                    bool useStaticBatches) const {
+  if (useStaticBatches && !batches.empty()) {
+    // Batches are already in world space
+    uint32_t transform = queue.pushTransform(glm::mat4(1.0f));
+    for (const StaticBatch& batch : batches) {
+      queue.push(batch.mesh, transform);
+    }
+  }
+
+  root.collect(queue, scheduler, glm::mat4(1.0f), time, useStaticBatches);
+}
+
+/**
+ * @brief Builds the static batches when batching is turned on and releases
+ * them when it is turned off.
+ *
+ * Batches hold a second copy of the static geometry, so they only exist
+ * while they are drawn.
+ *
+ * @param enabled Whether static batching is turned on.
+ */
+void Scene::setStaticBatching(bool enabled) {
+  if (enabled == staticBatching) {
+    return;
+  }
+  staticBatching = enabled;
+
+  if (enabled) {
+    batchReport = buildStaticBatches(root, batches);
+    return;
+  }
+
+  releaseStaticBatches(root, batches);
+  batchReport = StaticBatchReport();
+  // The rest of the scene stays in the heap
+  GeometryHeap::defragmentIfNeeded();
 }
 
-void Scene::clear() { root.clear(); }
\ No newline at end of file
+/**
+ * @brief Unloads the scene, returning its meshes to the GeometryHeap.
+ *
+ * The heap is not compacted, callers that keep it should call
+ * GeometryHeap::defragmentIfNeeded afterwards.
+ */
+void Scene::clear() {
+  releaseStaticBatches(root, batches);
+  root.clear();
+  batchReport = StaticBatchReport();
+  staticBatching = false;
+  clearTextureCache();
+}
\ No newline at end of file
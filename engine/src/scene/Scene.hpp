@@ -6,15 +6,26 @@
 #include "Group.hpp"
 #include "Light.hpp"
 #include "engine/Settings.hpp"
+#include "render/StaticBatch.hpp"
 
 struct Scene {
  private:
   Group root;
   vector<Light> lights;
-  float time = 0.0f;
+  vector<StaticBatch> batches;
+  StaticBatchReport batchReport;
+  bool staticBatching = false;
+  double time = 0.0;
 
  public:
-  void render(ViewMode viewMode, bool showNormals);
+  void collect(RenderQueue& queue, const AnimationScheduler& scheduler,
+               bool useStaticBatches) const;
+
+  void setStaticBatching(bool enabled);
+
+  const vector<StaticBatch>& getStaticBatches() const { return batches; }
+
+  const StaticBatchReport& getStaticBatchReport() const { return batchReport; }
 
   void setRoot(Group&& root) { this->root = std::move(root); }
 
@@ -24,9 +35,9 @@ struct Scene {
 
   void clear();
 
-  void updateTime(float delta) { time += delta; }
+  void setTime(double time) { this->time = time; }
 
-  float getTime() const { return time; }
+  double getTime() const { return time; }
 
   vector<Light>& getLights() { return lights; }
 };
\ No newline at end of file
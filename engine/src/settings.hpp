@@ -5,6 +5,8 @@ struct DisplaySettings {
   int width = 1280;
   int height = 720;
   int framerate = 120;
+  bool coreProfile = false;
+  bool offscreen = false;
 };
 
 struct EngineSettings {
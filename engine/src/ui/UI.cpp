@@ -1,6 +1,9 @@
 #include "UI.hpp"
 
+#include <algorithm>
+
 #include "../engine/Engine.hpp"
+#include "../render/GeometryHeap.hpp"
 
 void LoadMainFont(ImGuiIO& io) {
   ImFontConfig config;
@@ -18,9 +21,8 @@ void LoadIconFont(ImGuiIO& io) {
                                &config, icon_ranges);
 }
 
-void UI::DrawGroupTree(const Group& group, const std::string& name,
-                       NodeType type) {
-  if (SceneTreeNode(name.c_str(), type, true, type == NodeType::WORLD)) {
+void UI::DrawGroupTree(const Group& group, const char* name, NodeType type) {
+  if (SceneTreeNode(name, type, true, type == NodeType::WORLD)) {
     if (type == NodeType::WORLD) {
       // If this is the world node, add the camera
       SceneTreeNode("Camera", NodeType::CAMERA, false, false);
@@ -36,36 +38,38 @@ void UI::DrawGroupTree(const Group& group, const std::string& name,
               int pointCount = 0, dirCount = 0, spotCount = 0;
 
               for (auto& light : scene->getLights()) {
-                std::string label;
+                const char* kind;
+                int count;
                 NodeType nodeType;
 
                 switch (light.getType()) {
                   case LightType::DIRECTIONAL:
-                    label = dirCount++ == 0
-                                ? "Directional Light"
-                                : "Directional Light (" +
-                                      std::to_string(dirCount) + ")";
+                    kind = "Directional Light";
+                    count = ++dirCount;
                     nodeType = NodeType::LIGHT_DIRECTIONAL;
                     break;
                   case LightType::POINT:
-                    label = pointCount++ == 0
-                                ? "Point Light"
-                                : "Point Light (" + std::to_string(pointCount) +
-                                      ")";
+                    kind = "Point Light";
+                    count = ++pointCount;
                     nodeType = NodeType::LIGHT_POINT;
                     break;
                   case LightType::SPOTLIGHT:
-                    label =
-                        spotCount++ == 0
-                            ? "Spot Light"
-                            : "Spot Light (" + std::to_string(spotCount) + ")";
+                    kind = "Spot Light";
+                    count = ++spotCount;
                     nodeType = NodeType::LIGHT_SPOT;
                     break;
                   default:
                     continue;
                 }
 
-                SceneTreeNode(label.c_str(), nodeType, false, false);
+                // Formatted on the stack, the tree is rebuilt every frame
+                char label[64];
+                if (count == 1) {
+                  snprintf(label, sizeof(label), "%s", kind);
+                } else {
+                  snprintf(label, sizeof(label), "%s (%d)", kind, count);
+                }
+                SceneTreeNode(label, nodeType, false, false);
               }
 
               ImGui::TreePop();
@@ -76,7 +80,7 @@ void UI::DrawGroupTree(const Group& group, const std::string& name,
     }
 
     for (auto& child : group.getChildren()) {
-      DrawGroupTree(child, child.getName(), NodeType::GROUP);
+      DrawGroupTree(child, child.getName().c_str(), NodeType::GROUP);
     }
 
     for (auto& model : group.getModels()) {
@@ -86,17 +90,258 @@ void UI::DrawGroupTree(const Group& group, const std::string& name,
   }
 }
 
-void UI::initialize(Window* window) {
+void UI::DrawStaticBatches(const Scene& scene) {
+  const vector<StaticBatch>& batches = scene.getStaticBatches();
+  if (batches.empty()) {
+    return;
+  }
+
+  const StaticBatchReport& report = scene.getStaticBatchReport();
+
+  ImGui::Separator();
+  ImGui::Text("Static Batches: %zu (%zu models)", report.batchCount,
+              report.sourceCount);
+  ImGui::Text("Batch Memory: %.1f KB, built in %.2f ms",
+              report.gpuBytes / 1024.0, report.buildMilliseconds);
+
+  for (const StaticBatch& batch : batches) {
+    if (SceneTreeNode(batch.mesh.getName().c_str(), NodeType::GROUP, true,
+                      false)) {
+      for (const BatchSource& source : batch.sources) {
+        ImGui::PushID(source.model);
+        char label[256];
+        snprintf(label, sizeof(label), "%s / %s",
+                 source.group->getName().c_str(),
+                 source.model->getName().c_str());
+        SceneTreeNode(label, NodeType::MODEL, false, false);
+        ImGui::PopID();
+      }
+      ImGui::TreePop();
+    }
+  }
+}
+
+// Largest assets listed in the memory section
+static constexpr size_t MEMORY_TOP_COUNT = 8;
+
+static void DrawAssets(const char* label,
+                       const std::vector<AssetMemory>& assets) {
+  if (!ImGui::TreeNode(label, "%s (%zu)", label, assets.size())) {
+    return;
+  }
+  for (size_t i = 0; i < assets.size() && i < MEMORY_TOP_COUNT; i++) {
+    const AssetMemory& asset = assets[i];
+    ImGui::Text("%.1f KB CPU, %.1f KB GPU  %s", asset.cpuBytes / 1024.0,
+                asset.gpuBytes / 1024.0, asset.name.c_str());
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip("%s", asset.group.c_str());
+    }
+  }
+  ImGui::TreePop();
+}
+
+void UI::DrawMemory(const Scene& scene) {
+  ImGui::Separator();
+  if (!ImGui::CollapsingHeader("Memory")) {
+    return;
+  }
+
+  // Building the report walks the whole scene, so it is only done on demand
+  bool refresh = ImGui::Button("Refresh");
+  if (refresh || memoryReport.isEmpty()) {
+    memoryReport.build(scene);
+
+    // Sorted once per report rather than every frame the section is open
+    memoryGroups.clear();
+    for (const GroupMemory& group : memoryReport.getGroups()) {
+      memoryGroups.push_back(&group);
+    }
+    std::sort(memoryGroups.begin(), memoryGroups.end(),
+              [](const GroupMemory* a, const GroupMemory* b) {
+                return a->subtreeCpuBytes + a->subtreeGpuBytes >
+                       b->subtreeCpuBytes + b->subtreeGpuBytes;
+              });
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Dump JSON")) {
+    const char* filters[] = {"*.json"};
+    const char* file = tinyfd_saveFileDialog(
+        "Dump Memory Report", "memory.json", 1, filters, "JSON files");
+    if (file) {
+      memoryReport.writeJson(file);
+    }
+  }
+
+  ImGui::Text("Models: %.2f MB CPU, %.2f MB GPU",
+              memoryReport.getModelCpuBytes() / (1024.0 * 1024.0),
+              memoryReport.getModelGpuBytes() / (1024.0 * 1024.0));
+  ImGui::Text("Textures: %.2f MB GPU",
+              memoryReport.getTextureGpuBytes() / (1024.0 * 1024.0));
+  ImGui::Text("Peak Resident: %.2f MB",
+              memoryReport.getPeakResidentBytes() / (1024.0 * 1024.0));
+
+  DrawAssets("Models", memoryReport.getModels());
+  DrawAssets("Textures", memoryReport.getTextures());
+
+  if (ImGui::TreeNode("Groups")) {
+    for (size_t i = 0; i < memoryGroups.size() && i < MEMORY_TOP_COUNT; i++) {
+      ImGui::Text("%.1f KB CPU, %.1f KB GPU  %s",
+                  memoryGroups[i]->subtreeCpuBytes / 1024.0,
+                  memoryGroups[i]->subtreeGpuBytes / 1024.0,
+                  memoryGroups[i]->path.c_str());
+    }
+    ImGui::TreePop();
+  }
+}
+
+static void DrawArenaOccupancy(const char* label,
+                               const RangeAllocator& allocator) {
+  uint32_t capacity = allocator.getCapacity();
+  uint32_t used = capacity - allocator.getFreeSize();
+  float occupancy = capacity > 0 ? static_cast<float>(used) / capacity : 0.0f;
+
+  char overlay[64];
+  snprintf(overlay, sizeof(overlay), "%u / %u", used, capacity);
+  ImGui::Text("%s", label);
+  ImGui::ProgressBar(occupancy, ImVec2(-1.0f, 0.0f), overlay);
+
+  if (ImGui::TreeNode(label, "Free Ranges (%zu)",
+                      allocator.getFreeRanges().size())) {
+    for (const HeapRange& range : allocator.getFreeRanges()) {
+      ImGui::Text("[%u, %u) %u", range.offset, range.offset + range.size,
+                  range.size);
+    }
+    ImGui::TreePop();
+  }
+}
+
+void UI::DrawGeometryHeap() {
+  ImGui::Text("Live Allocations: %zu", GeometryHeap::getLiveAllocationCount());
+  ImGui::Text("Fragmentation: %.1f%%",
+              GeometryHeap::getFragmentation() * 100.0f);
+  ImGui::Text("Defragmentations: %u", GeometryHeap::getDefragmentationCount());
+
+  ImGui::Separator();
+  DrawArenaOccupancy("Vertices", GeometryHeap::getVertexAllocator());
+  DrawArenaOccupancy("Indices", GeometryHeap::getIndexAllocator());
+
+  ImGui::Separator();
+  if (ImGui::Button("Defragment")) {
+    GeometryHeap::defragment();
+  }
+}
+
+static ImU32 ZoneColor(const char* name) {
+  // Zone names are literals, so their address picks a stable hue
+  uint32_t hash = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(name) >> 3);
+  hash *= 2654435761u;
+  float hue = (hash >> 8) / static_cast<float>(1 << 24);
+  float r, g, b;
+  ImGui::ColorConvertHSVtoRGB(hue, 0.55f, 0.8f, r, g, b);
+  return ImGui::GetColorU32(ImVec4(r, g, b, 1.0f));
+}
+
+void UI::DrawProfiler() {
+  if (!debug::Profiler::isCompiledIn()) {
+    ImGui::Text("Profiling is compiled out of this build.");
+    return;
+  }
+
+  bool profilerEnabled = debug::Profiler::isEnabled();
+  if (ImGui::Checkbox("Enabled", &profilerEnabled)) {
+    debug::Profiler::setEnabled(profilerEnabled);
+  }
+  ImGui::SameLine();
+  ImGui::Checkbox("Pause", &profilerPaused);
+  ImGui::SameLine();
+  if (ImGui::Button("Export Trace")) {
+    const char* filters[] = {"*.json"};
+    const char* file = tinyfd_saveFileDialog("Export Chrome Trace",
+                                             "trace.json", 1, filters,
+                                             "JSON files");
+    if (file) {
+      debug::Profiler::exportChromeTrace(file);
+    }
+  }
+
+  if (!profilerPaused) {
+    debug::Profiler::getLastFrame(profilerEvents, profilerFrameStart,
+                                  profilerFrameEnd);
+  }
+  Engine* engine =
+      static_cast<Engine*>(glfwGetWindowUserPointer(window->getGlfwWindow()));
+  if (engine && engine->getGpuTimer().isSupported()) {
+    // GPU phases lag the CPU zones by the frames in flight
+    const GpuTimer& gpuTimer = engine->getGpuTimer();
+    ImGui::Text("GPU: %.3f ms", gpuTimer.getTotalMilliseconds());
+    for (int i = 0; i < GPU_PHASE_COUNT; i++) {
+      GpuPhase phase = static_cast<GpuPhase>(i);
+      ImGui::SameLine();
+      ImGui::Text("| %s %.3f", GpuTimer::getPhaseName(phase),
+                  gpuTimer.getMilliseconds(phase));
+    }
+  }
+
+  if (profilerEvents.empty() || profilerFrameEnd <= profilerFrameStart) {
+    ImGui::Text("No zones recorded.");
+    return;
+  }
+
+  double frameNanoseconds =
+      static_cast<double>(profilerFrameEnd - profilerFrameStart);
+  ImGui::Text("Frame: %.3f ms", frameNanoseconds / 1e6);
+
+  uint32_t rows = 0;
+  for (const debug::ProfileEvent& event : profilerEvents) {
+    rows = std::max(rows, event.depth + 1);
+  }
+
+  // One row per nesting depth, scaled so the frame fills the panel
+  float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+  ImGui::InvisibleButton("##Timeline", ImVec2(width, rows * rowHeight));
+  bool hovered = ImGui::IsItemHovered();
+  ImVec2 mouse = ImGui::GetIO().MousePos;
+
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  float scale = static_cast<float>(width / frameNanoseconds);
+  for (const debug::ProfileEvent& event : profilerEvents) {
+    float x0 = origin.x + (event.start - profilerFrameStart) * scale;
+    float x1 = origin.x + (event.end - profilerFrameStart) * scale;
+    x1 = std::max(x1, x0 + 1.0f);
+    float y0 = origin.y + event.depth * rowHeight;
+    ImVec2 min(x0, y0);
+    ImVec2 max(x1, y0 + rowHeight - 1.0f);
+
+    drawList->AddRectFilled(min, max, ZoneColor(event.name));
+    drawList->PushClipRect(min, max, true);
+    drawList->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32_BLACK,
+                      event.name);
+    drawList->PopClipRect();
+
+    if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y &&
+        mouse.y < max.y) {
+      ImGui::SetTooltip("%s: %.3f ms", event.name,
+                        (event.end - event.start) / 1e6);
+    }
+  }
+}
+
+void UI::initialize(Window* window, const char* glslVersion) {
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
   this->io = &ImGui::GetIO();
   (void)io;
   ImGui::StyleColorsDark();
   ImGui_ImplGlfw_InitForOpenGL(window->getGlfwWindow(), true);
-  ImGui_ImplOpenGL3_Init("#version 130");
+  ImGui_ImplOpenGL3_Init(glslVersion);
   LoadMainFont(*io);
   LoadIconFont(*io);
   this->window = window;
+  // A new window means a new scene
+  memoryReport = MemoryReport();
+  memoryGroups.clear();
   io->FontGlobalScale = 1.5f;
   io->ConfigFlags |= ImGuiConfigFlags_DockingEnable;
 }
@@ -141,6 +386,12 @@ void UI::render() {
       if (ImGui::MenuItem("Engine")) {
         showOptionsWindow = !showOptionsWindow;
       }
+      if (ImGui::MenuItem("Geometry Heap")) {
+        showGeometryHeapWindow = !showGeometryHeapWindow;
+      }
+      if (ImGui::MenuItem("Profiler")) {
+        showProfilerWindow = !showProfilerWindow;
+      }
       ImGui::EndMenu();
     }
 
@@ -156,16 +407,99 @@ void UI::render() {
   ImGui::Begin(
       "Performance", nullptr,
       ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize);
+  Engine* engine =
+      static_cast<Engine*>(glfwGetWindowUserPointer(window->getGlfwWindow()));
   ImGui::Text("FPS: %.1f", io->Framerate);
+  if (engine) {
+    // Raw frame times, the averaged FPS above hides stutters
+    FrameTimeHistory& frameTimes = engine->getFrameTimes();
+    ImGui::PlotLines("##FrameTimes", frameTimes.getSamples(),
+                     frameTimes.getCount(), frameTimes.getOffset(), nullptr,
+                     0.0f, frameTimes.getP99() * 1.5f, ImVec2(300.0f, 60.0f));
+    ImGui::Text("Frame: %.2f ms (p50 %.2f, p95 %.2f, p99 %.2f, max %.2f)",
+                frameTimes.getLast(), frameTimes.getP50(),
+                frameTimes.getP95(), frameTimes.getP99(), frameTimes.getMax());
+    ImGui::Text("Hitches: %u", frameTimes.getHitches());
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Reset")) {
+      frameTimes.reset();
+    }
+
+    const RenderStats& stats = engine->getRenderStats();
+    ImGui::Text("Draw Calls: %u", stats.drawCalls);
+    ImGui::Text("Triangles: %llu (%llu vertices)",
+                static_cast<unsigned long long>(stats.triangles),
+                static_cast<unsigned long long>(stats.vertices));
+    ImGui::Text("State Changes: %u (%u materials)", stats.stateChanges,
+                stats.materialChanges);
+    ImGui::Text("Binds: %u buffers, %u textures", stats.bufferBinds,
+                stats.textureBinds);
+    ImGui::Text("Groups: %u (%u models culled)", stats.groupsTraversed,
+                stats.culledDraws);
+    if (stats.activeLights > 0) {
+      ImGui::Text("Active Lights: %u", stats.activeLights);
+    }
+    ImGui::Text("Animations: %u (%u deferred)", stats.animationsEvaluated,
+                stats.animationsDeferred);
+    if (stats.multiDrawIndirect) {
+      ImGui::Text("Indirect Commands: %u", stats.indirectCommands);
+    }
+    ImGui::Text("Submit: %.3f ms", stats.submitMilliseconds);
+    const GpuTimer& gpuTimer = engine->getGpuTimer();
+    if (gpuTimer.isSupported()) {
+      ImGui::Text("GPU: %.3f ms", gpuTimer.getTotalMilliseconds());
+    }
+    if (stats.lights > 0) {
+      ImGui::Text("Lights: %u (max %u per cluster)", stats.lights,
+                  stats.maxClusterLights);
+      ImGui::Text("Light Binning: %.3f ms", stats.lightBinningMilliseconds);
+    }
+    if (stats.lightRebinds > 0) {
+      ImGui::Text("Light Rebinds: %u", stats.lightRebinds);
+    }
+    ImGui::Text("GL Calls: %u (%u skipped)", StateCache::getIssuedCalls(),
+                StateCache::getSkippedCalls());
+    if (engine->getSettings()->getViewmode() == OVERDRAW) {
+      // Fragments that passed the depth test, per pixel
+      const OverdrawView& overdraw = engine->getOverdrawView();
+      ImGui::Text("Overdraw: %.2fx covered, %.2fx screen (max %u)",
+                  overdraw.getAverage(), overdraw.getScreenAverage(),
+                  overdraw.getMax());
+      ImGui::Text("Coverage: %.1f%%", overdraw.getCoverage() * 100.0f);
+    }
+    if (debug::AllocationTracker::isCompiledIn()) {
+      debug::AllocationCounts allocations =
+          debug::AllocationTracker::getFrameTotal();
+      ImGui::Text("Allocations: %llu (%.1f KB), %llu frees",
+                  static_cast<unsigned long long>(allocations.allocations),
+                  allocations.bytes / 1024.0,
+                  static_cast<unsigned long long>(allocations.frees));
+      if (allocations.allocations > 0 && ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        for (int i = 0; i < debug::ALLOC_PHASE_COUNT; i++) {
+          debug::AllocationPhase phase = static_cast<debug::AllocationPhase>(i);
+          const debug::AllocationCounts& counts =
+              debug::AllocationTracker::getFrame(phase);
+          if (counts.allocations > 0) {
+            ImGui::Text("%s: %llu (%.1f KB)",
+                        debug::AllocationTracker::getPhaseName(phase),
+                        static_cast<unsigned long long>(counts.allocations),
+                        counts.bytes / 1024.0);
+          }
+        }
+        ImGui::EndTooltip();
+      }
+    }
+  }
   ImGui::End();
 
   ImGui::Begin("Inspector");
-  Engine* engine =
-      static_cast<Engine*>(glfwGetWindowUserPointer(window->getGlfwWindow()));
   if (engine) {
     Scene* scene = engine->getScene();
     if (scene) {
       DrawGroupTree(scene->getRoot(), "World", NodeType::WORLD);
+      DrawStaticBatches(*scene);
+      DrawMemory(*scene);
     }
 
     ImGui::SetNextWindowSizeConstraints(ImVec2(500.0f, 0),
@@ -187,24 +521,28 @@ void UI::render() {
           ImGui::SameLine();
           ImGui::Checkbox("##ShowAxis", &settings->showAxis);
 
-          const char* viewModeItems[] = {"Wireframe", "Flat", "Shaded"};
+          ImGui::Text("Static Batching");
+          ImGui::SameLine();
+          ImGui::Checkbox("##StaticBatching", &settings->staticBatching);
+
+          ImGui::Text("Animation LOD");
+          ImGui::SameLine();
+          ImGui::Checkbox("##AnimationLod", &settings->animationLod);
+
+          ImGui::Text("Multi-Draw Indirect");
+          ImGui::SameLine();
+          ImGui::Checkbox("##MultiDrawIndirect", &settings->multiDrawIndirect);
+
+          const char* viewModeItems[] = {"Wireframe", "Flat", "Shaded",
+                                         "Overdraw"};
           int currentViewMode = static_cast<int>(settings->viewMode);
 
           ImGui::Text("View Mode");
           ImGui::SameLine();
           if (ImGui::Combo("##ViewModeCombo", &currentViewMode, viewModeItems,
                            IM_ARRAYSIZE(viewModeItems))) {
-            if (currentViewMode == 0) {
-              glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-              glDisable(GL_LIGHTING);
-            } else if (currentViewMode == 1) {
-              glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-              glDisable(GL_LIGHTING);
-            } else if (currentViewMode == 2) {
-              glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-              glEnable(GL_LIGHTING);
-            }
             settings->viewMode = static_cast<ViewMode>(currentViewMode);
+            engine->applyViewMode();
           }
 
           ImGui::Text("Simulation");
@@ -213,6 +551,25 @@ void UI::render() {
                                                : ICON_FA_PAUSE)) {
             settings->isPaused = !settings->isPaused;
           }
+
+          ImGui::Text("Time Warp");
+          ImGui::SameLine();
+          ImGui::SliderFloat("##TimeWarp", &settings->timeWarp, 0.1f, 1000.0f,
+                             "%.1fx", ImGuiSliderFlags_Logarithmic);
+
+          ImGui::Text("Hitch Threshold");
+          ImGui::SameLine();
+          ImGui::SliderFloat("##HitchFactor", &settings->hitchFactor, 1.5f,
+                             10.0f, "%.1fx median");
+
+          const SimulationClock& clock = engine->getClock();
+          ImGui::Text("Time: %.2f s (%u steps/frame)", clock.getTime(),
+                      clock.getSubsteps());
+          if (clock.getDroppedTicks() > 0) {
+            ImGui::Text("Dropped Steps: %llu",
+                        static_cast<unsigned long long>(
+                            clock.getDroppedTicks()));
+          }
         }
       } else {
         ImGui::Text("Error loading engine.");
@@ -220,6 +577,18 @@ void UI::render() {
 
       ImGui::End();
     }
+
+    if (showGeometryHeapWindow) {
+      ImGui::Begin("Geometry Heap", &showGeometryHeapWindow);
+      DrawGeometryHeap();
+      ImGui::End();
+    }
+
+    if (showProfilerWindow) {
+      ImGui::Begin("Profiler", &showProfilerWindow);
+      DrawProfiler();
+      ImGui::End();
+    }
   }
 
   ImGui::End();
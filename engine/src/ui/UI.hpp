@@ -6,6 +6,9 @@
 #include <imgui_internal.h>
 #include <tinyfiledialogs/tinyfiledialogs.h>
 
+#include "../debug/Allocations.hpp"
+#include "../debug/Profiler.hpp"
+#include "../scene/MemoryReport.hpp"
 #include "../scene/Scene.hpp"
 #include "../window/Window.hpp"
 #include "imgui_impl_glfw.h"
@@ -43,17 +46,28 @@ class UI {
   ImGuiIO* io = nullptr;
   bool enabled = true;
   bool showOptionsWindow = false;
+  bool showGeometryHeapWindow = false;
+  bool showProfilerWindow = false;
+  bool profilerPaused = false;
+  std::vector<debug::ProfileEvent> profilerEvents;
+  uint64_t profilerFrameStart = 0;
+  uint64_t profilerFrameEnd = 0;
+  MemoryReport memoryReport;
+  std::vector<const GroupMemory*> memoryGroups;
 
  public:
   void toggleUI();
-  void initialize(Window* window);
+  void initialize(Window* window, const char* glslVersion = "#version 130");
   void terminate();
   void render();
   void postRender();
   void shutdown();
   void setFPS(float fps) { this->fps = fps; }
-  void DrawGroupTree(const Group& group, const std::string& name,
-                     NodeType type);
+  void DrawGroupTree(const Group& group, const char* name, NodeType type);
+  void DrawStaticBatches(const Scene& scene);
+  void DrawMemory(const Scene& scene);
+  void DrawGeometryHeap();
+  void DrawProfiler();
 };
 
 void LoadMainFont(ImGuiIO& io);
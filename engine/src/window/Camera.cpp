@@ -1,9 +1,8 @@
 #include "Camera.hpp"
 
-void Camera::render() {
-  gluLookAt(position.x, position.y, position.z, lookingAt.x, lookingAt.y,
-            lookingAt.z, up.x, up.y, up.z);
-}
+#include "render/StateCache.hpp"
+
+void Camera::render() { StateCache::loadModelView(getViewMatrix()); }
 
 void Camera::setPosition(glm::vec3 position) { this->position = position; }
 
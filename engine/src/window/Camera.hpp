@@ -1,9 +1,11 @@
 #pragma once
 
+#include <GL/glew.h>
 #define GLFW_INCLUDE_GLU
 #include <GLFW/glfw3.h>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <vector>
 
 using glm::vec3;
@@ -56,6 +58,10 @@ class Camera {
   vec3 getPosition() { return position; }
   vec3 getLookingAt() { return lookingAt; }
   vec3 getUp() { return up; }
+  glm::mat4 getViewMatrix() { return glm::lookAt(position, lookingAt, up); }
+  glm::mat4 getProjectionMatrix(float aspectRatio) {
+    return glm::perspective(glm::radians(fov), aspectRatio, near, far);
+  }
   void processKeyboard(int key, int action);
   void processMouseMovement(double xpos, double ypos);
   void update(float deltaTime);
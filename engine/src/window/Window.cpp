@@ -17,13 +17,47 @@ bool Window::initialize(DisplaySettings* settings, const char* title) {
   Window::width = settings->width;
   Window::height = settings->height;
 
+#if GLFW_VERSION_MAJOR * 100 + GLFW_VERSION_MINOR >= 304
+  if (settings->offscreen) {
+    // Headless machines have no display server to connect to
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
+
   if (glfwInit() == GLFW_FALSE) {
     logger.error("Failed to initialize GLFW.");
     return false;
   }
 
+  if (settings->coreProfile) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+  } else {
+    glfwDefaultWindowHints();
+  }
+  // The overdraw view counts fragments in the stencil buffer
+  glfwWindowHint(GLFW_STENCIL_BITS, 8);
+
+  if (settings->offscreen) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#if GLFW_VERSION_MAJOR * 100 + GLFW_VERSION_MINOR >= 304
+    // Surfaceless EGL first, then OSMesa where EGL is not available
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+  }
+
   glfwWindow = glfwCreateWindow(width, height, title, nullptr, nullptr);
 
+#if GLFW_VERSION_MAJOR * 100 + GLFW_VERSION_MINOR >= 304
+  if (glfwWindow == nullptr && settings->offscreen) {
+    logger.info("No EGL context, falling back to OSMesa.");
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    glfwWindow = glfwCreateWindow(width, height, title, nullptr, nullptr);
+  }
+#endif
+
   if (glfwWindow == nullptr) {
     logger.error("Failed to create GLFW window.");
     glfwTerminate();
@@ -0,0 +1,184 @@
+"""Benchmarks every scene offscreen and compares the results to baselines.
+
+Runs the engine with --offscreen --benchmark on each scene, which orbits the
+camera around its target over a fixed number of frames, and compares the
+reported metrics to <baselines>/<scene>.json. A metric regresses when it grows
+by more than its relative tolerance in benchmarks/tolerances.json, where
+"scenes" overrides the "default" tolerances per scene; metrics without a
+tolerance are only reported. Scenes listed in "excluded", with the reason they
+cannot be measured, are skipped and count as passed. Exits with 1 if any
+scene regressed, failed to run or has no baseline, unless --allow-missing is
+given. Run it from the repository root so the engine finds its assets, and
+use --update to write the current results as the new baselines.
+
+The committed baselines in benchmarks/baselines only hold the counters that
+do not depend on the machine, draw_calls and triangles, measured with the
+core renderer, so --update only writes those there. Timings are only worth
+comparing on the machine that measured them: --baselines DIR writes and
+compares every metric, load, frame and GPU times and peak memory included,
+against baselines kept in DIR.
+
+Example:
+    python utils/benchmark_suite.py build/engine/engine
+    python utils/benchmark_suite.py build/engine/engine --update \
+        --baselines ~/engine_baselines
+    python utils/benchmark_suite.py build/engine/engine \
+        --baselines ~/engine_baselines
+"""
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+BASELINES = os.path.join("benchmarks", "baselines")
+TOLERANCES = os.path.join("benchmarks", "tolerances.json")
+PORTABLE_METRICS = ("draw_calls", "triangles")
+
+
+def run_engine(engine, scene, renderer, frames):
+    with tempfile.TemporaryDirectory() as directory:
+        report = os.path.join(directory, "benchmark.json")
+        command = [engine, scene, "--offscreen", "--renderer", renderer,
+                   "--frames", str(frames), "--benchmark", report]
+        result = subprocess.run(command, capture_output=True, text=True)
+
+        if result.returncode != 0 or not os.path.exists(report):
+            sys.stderr.write(result.stdout + result.stderr)
+            raise RuntimeError("No benchmark report from: " +
+                               " ".join(command))
+        with open(report, encoding="utf-8") as file:
+            return json.load(file)
+
+
+def flatten(results, prefix=""):
+    metrics = {}
+    for key, value in results.items():
+        if isinstance(value, dict):
+            metrics.update(flatten(value, prefix + key + "."))
+        elif isinstance(value, (int, float)):
+            metrics[prefix + key] = value
+    return metrics
+
+
+def compare(name, results, baseline, tolerances):
+    current = flatten(results)
+    expected = flatten(baseline)
+    regressions = []
+
+    for metric in sorted(current):
+        if metric not in expected:
+            continue
+        before = expected[metric]
+        after = current[metric]
+        change = (after - before) / before if before else 0.0
+        limit = tolerances.get(metric)
+        status = ""
+        if limit is not None and after > before * (1.0 + limit) + 1e-9:
+            status = "REGRESSION"
+            regressions.append(metric)
+        print("%-20s %-16s %12.3f %12.3f %+8.1f%% %s" %
+              (name, metric, before, after, 100.0 * change, status))
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("engine", help="path to the engine executable")
+    parser.add_argument("--scenes", nargs="+",
+                        help="scene names to run (default: all in scenes/)")
+    parser.add_argument("--renderer", default="core",
+                        choices=["legacy", "core"])
+    parser.add_argument("--frames", type=int, default=300)
+    parser.add_argument("--update", action="store_true",
+                        help="write the results as the new baselines")
+    parser.add_argument("--baselines", default=BASELINES,
+                        help="directory of the baselines, every metric is "
+                             "written and compared unless it is the "
+                             "committed one (default: %(default)s)")
+    parser.add_argument("--allow-missing", action="store_true",
+                        help="do not fail on scenes without a baseline")
+    args = parser.parse_args()
+    portable = os.path.abspath(args.baselines) == os.path.abspath(BASELINES)
+
+    if args.scenes:
+        scenes = [os.path.join("scenes", name + ".xml")
+                  for name in args.scenes]
+    else:
+        scenes = sorted(glob.glob(os.path.join("scenes", "*.xml")))
+
+    with open(TOLERANCES, encoding="utf-8") as file:
+        config = json.load(file)
+    excluded = config.get("excluded", {})
+    os.makedirs(args.baselines, exist_ok=True)
+
+    failed = []
+    errors = []
+    missing = []
+    skipped = []
+    for scene in scenes:
+        name = os.path.splitext(os.path.basename(scene))[0]
+        if name in excluded:
+            print("%-20s EXCLUDED: %s" % (name, excluded[name]))
+            skipped.append(name)
+            continue
+        try:
+            results = run_engine(args.engine, scene, args.renderer,
+                                 args.frames)
+        except RuntimeError as error:
+            print("%-20s FAILED: %s" % (name, error))
+            errors.append(name)
+            continue
+        baseline_path = os.path.join(args.baselines, name + ".json")
+
+        if args.update:
+            if portable:
+                results = {metric: results[metric]
+                           for metric in PORTABLE_METRICS
+                           if metric in results}
+            with open(baseline_path, "w", encoding="utf-8") as file:
+                json.dump(results, file, indent=2)
+                file.write("\n")
+            print("%-20s baseline written" % name)
+            continue
+
+        if not os.path.exists(baseline_path):
+            print("%-20s NO BASELINE" % name)
+            missing.append(name)
+            continue
+
+        with open(baseline_path, encoding="utf-8") as file:
+            baseline = json.load(file)
+        tolerances = dict(config.get("default", {}))
+        tolerances.update(config.get("scenes", {}).get(name, {}))
+        if compare(name, results, baseline, tolerances):
+            failed.append(name)
+
+    print("%d scenes run, %d excluded" %
+          (len(scenes) - len(skipped), len(skipped)))
+    status = 0
+    if failed:
+        print("regressions in: " + ", ".join(failed))
+        status = 1
+    if errors:
+        print("failed to run: " + ", ".join(errors))
+        status = 1
+    if missing and not args.update:
+        print("=" * 72)
+        print("%d of %d scenes were NOT compared, they have no baseline:" %
+              (len(missing), len(scenes)))
+        print("    " + ", ".join(missing))
+        print("Write them with --update, exclude them in %s, or pass "
+              "--allow-missing." % TOLERANCES)
+        print("=" * 72)
+        if not args.allow_missing:
+            status = 1
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,54 @@
+"""Sweeps the synthetic light count of the engine and reports frame times.
+
+Runs the engine once per light count with --frames, parses the timing summary
+it logs on exit and prints a CSV table. Run it from the repository root so the
+engine finds its assets.
+
+Example:
+    python utils/light_sweep.py build/engine/engine scenes/scene_sponza.xml \
+        --counts 0 64 128 256 512 1024
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+SUMMARY = re.compile(
+    r"Rendered (\d+) frames with the (\w+) renderer in ([\d.]+) s: "
+    r"([\d.]+) ms/frame \(([\d.]+) FPS\), ([\d.]+) ms submit")
+
+
+def run_engine(engine, scene, renderer, frames, lights):
+    command = [engine, scene, "--renderer", renderer, "--frames", str(frames),
+               "--synthetic-lights", str(lights)]
+    result = subprocess.run(command, capture_output=True, text=True)
+
+    match = SUMMARY.search(result.stdout)
+    if match is None:
+        sys.stderr.write(result.stdout + result.stderr)
+        raise RuntimeError("No timing summary from: " + " ".join(command))
+
+    return float(match.group(4)), float(match.group(5)), float(match.group(6))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("engine", help="path to the engine executable")
+    parser.add_argument("scene", help="scene file to render")
+    parser.add_argument("--renderer", default="core",
+                        choices=["core", "legacy"])
+    parser.add_argument("--frames", type=int, default=500)
+    parser.add_argument("--counts", type=int, nargs="+",
+                        default=[0, 32, 64, 128, 256, 512, 1024])
+    args = parser.parse_args()
+
+    print("lights,ms_per_frame,fps,submit_ms")
+    for count in args.counts:
+        frame, fps, submit = run_engine(args.engine, args.scene, args.renderer,
+                                        args.frames, count)
+        print(f"{count},{frame:.3f},{fps:.1f},{submit:.3f}", flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,99 @@
+"""Replaces sampled circular paths in a scene with analytic orbits.
+
+Every <translate time=...> whose points lie on a circle around the origin of
+the XZ plane, sampled at equal angles from +X towards -Z, becomes an
+<orbit radius period phase> element. Other paths are left untouched. The rest
+of the file is copied verbatim and the parse size savings are printed.
+
+Example:
+    python utils/orbit_convert.py scenes/solar_system_phase_4.xml \
+        scenes/solar_system_phase_4_orbits.xml
+"""
+
+import argparse
+import math
+import re
+import sys
+
+# A self-closing <translate x y z /> has no body and must not open a match
+TRANSLATE = re.compile(r"<translate\b([^>]*?)(?<!/)>(.*?)</translate>",
+                       re.DOTALL)
+ATTRIBUTE = re.compile(r'(\w+)="([^"]*)"')
+POINT = re.compile(r"<point\b([^>]*)/>")
+
+TOLERANCE = 1e-3
+
+
+def as_orbit(attributes, body):
+    if "time" not in attributes:
+        return None
+    if attributes.get("align", "false").lower() == "true":
+        return None
+
+    points = []
+    for match in POINT.finditer(body):
+        point = dict(ATTRIBUTE.findall(match.group(1)))
+        points.append(tuple(float(point.get(axis, 0)) for axis in "xyz"))
+    if len(points) < 4:
+        return None
+
+    radius = sum(math.hypot(x, z) for x, _, z in points) / len(points)
+    if radius <= 0:
+        return None
+
+    start = math.atan2(-points[0][2], points[0][0])
+    for k, (x, y, z) in enumerate(points):
+        angle = start + 2 * math.pi * k / len(points)
+        expected = (radius * math.cos(angle), -radius * math.sin(angle))
+        error = math.hypot(x - expected[0], z - expected[1]) + abs(y)
+        if error > TOLERANCE * radius:
+            return None
+
+    phase = math.degrees(start) % 360
+    orbit = '<orbit radius="%r" period="%s"' % (radius, attributes["time"])
+    if phase > TOLERANCE:
+        orbit += ' phase="%r"' % phase
+    if attributes.get("render_path", "false").lower() == "true":
+        orbit += ' render_path="true"'
+    return orbit + " />", len(points)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    with open(args.input, encoding="utf-8") as file:
+        scene = file.read()
+
+    converted = 0
+    removed_points = 0
+
+    def replace(match):
+        nonlocal converted, removed_points
+        result = as_orbit(dict(ATTRIBUTE.findall(match.group(1))),
+                          match.group(2))
+        if result is None:
+            return match.group(0)
+        converted += 1
+        removed_points += result[1]
+        return result[0]
+
+    output = TRANSLATE.sub(replace, scene)
+
+    with open(args.output, "w", encoding="utf-8") as file:
+        file.write(output)
+
+    before = len(scene.encode("utf-8"))
+    after = len(output.encode("utf-8"))
+    print("paths converted: %d (%d points removed)" % (converted,
+                                                         removed_points))
+    print("paths kept: %d" % len(TRANSLATE.findall(output)))
+    print("scene size: %d -> %d bytes (%.1f%% smaller)" %
+          (before, after, 100.0 * (before - after) / before))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())